@@ -0,0 +1,127 @@
+//===- CallSites.cpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#include "CallSites.hpp"
+#include "ExprNames.hpp"
+#include <clang/AST/ExprCXX.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <experimental/iterator>
+#include <iterator>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/Twine.h>
+#include <sstream>
+
+using namespace clang;
+
+std::vector<std::string> getParamNames(const FunctionDecl *FD) {
+  std::vector<std::string> Ret;
+  llvm::transform(FD->parameters(), std::back_inserter(Ret),
+                  [](const ParmVarDecl *PVD) {
+    return PVD->getName().str();
+  });
+  return Ret;
+}
+
+static std::string
+flattenMorphemeListForDiag(const swapped_arg::MorphemeList &M) {
+  // The list is ordered by interned identifier, so sort the morphemes to keep
+  // the diagnostic stable.
+  std::vector<std::string> Sorted(M.begin(), M.end());
+  llvm::sort(Sorted);
+  std::ostringstream OS;
+  std::copy(Sorted.begin(), Sorted.end(),
+            std::experimental::make_ostream_joiner(OS, ", "));
+  return OS.str();
+}
+
+std::string describeSwap(const swapped_arg::Result &R) {
+  return ("arguments " + llvm::Twine(R.arg1) + " and " + llvm::Twine(R.arg2) +
+          " are swapped with morpheme1 = " +
+          flattenMorphemeListForDiag(R.morphemes1) +
+          " and morpheme2 = " + flattenMorphemeListForDiag(R.morphemes2))
+      .str();
+}
+
+namespace {
+class CallVisitor : public RecursiveASTVisitor<CallVisitor> {
+  ASTContext &Ctx;
+  CallSiteCallback Fn;
+
+public:
+  CallVisitor(ASTContext &Ctx, CallSiteCallback Fn) : Ctx(Ctx), Fn(Fn) {}
+
+  // Calls in a template are visited once per instantiation, where the callee
+  // and the argument types are known.
+  bool shouldVisitTemplateInstantiations() const { return true; }
+
+  bool VisitCallExpr(CallExpr *CE) {
+    if (CE->isTypeDependent() || CE->isValueDependent())
+      return true;
+    const FunctionDecl *FD = CE->getDirectCallee();
+    if (!FD)
+      return true;
+
+    // An overloaded operator implemented as a member function passes the
+    // object as its first argument, which has no matching parameter. Skip it
+    // so the arguments line up with the parameters, as the analyzer does.
+    llvm::ArrayRef<const Expr *> Args(CE->getArgs(), CE->getNumArgs());
+    if (isa<CXXOperatorCallExpr>(CE) && isa<CXXMethodDecl>(FD))
+      Args = Args.drop_front();
+    visitCall(CE, FD, Args);
+    return true;
+  }
+
+  // Constructor calls are not CallExprs, but the analyzer checks them too. This
+  // also visits CXXTemporaryObjectExprs, which are CXXConstructExprs.
+  bool VisitCXXConstructExpr(CXXConstructExpr *CCE) {
+    if (CCE->isTypeDependent() || CCE->isValueDependent())
+      return true;
+    visitCall(CCE, CCE->getConstructor(),
+              llvm::ArrayRef<const Expr *>(CCE->getArgs(), CCE->getNumArgs()));
+    return true;
+  }
+
+private:
+  void visitCall(const Expr *Call, const FunctionDecl *FD,
+                 llvm::ArrayRef<const Expr *> Args) {
+    swapped_arg::CallSite CS;
+    CS.callDecl.fullyQualifiedName = FD->getQualifiedNameAsString();
+    CS.callDecl.paramNames = getParamNames(FD);
+    const SourceManager &SM = Ctx.getSourceManager();
+    for (const Expr *Arg : Args)
+      CS.positionalArgNames.push_back(
+          {exprName(Call, Arg, SM, Ctx.getLangOpts())});
+
+    Fn(Call, FD, Args, CS);
+  }
+};
+} // namespace
+
+void forEachCallSite(ASTContext &Ctx, CallSiteCallback Fn) {
+  CallVisitor(Ctx, Fn).TraverseDecl(Ctx.getTranslationUnitDecl());
+}
+
+void checkCalls(swapped_arg::Checker &Check, ASTContext &Ctx,
+                SwapCallback Report) {
+  forEachCallSite(Ctx, [&](const Expr *Call, const FunctionDecl *,
+                           llvm::ArrayRef<const Expr *> Args,
+                           swapped_arg::CallSite &CS) {
+    Check.CheckSite(CS, [&](const swapped_arg::Result &R) {
+      // Result argument indexes are one-based.
+      Report(Call, Args[R.arg1 - 1], Args[R.arg2 - 1], R);
+      return true;
+    });
+  });
+}
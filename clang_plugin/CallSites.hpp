@@ -0,0 +1,60 @@
+//===- CallSites.hpp --------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PLUGIN_CALLSITES_H
+#define PLUGIN_CALLSITES_H
+
+#include "SwappedArgChecker.hpp"
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/Expr.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/STLExtras.h>
+#include <string>
+#include <vector>
+
+/// Collects the names of the function's parameters, in declaration order.
+std::vector<std::string> getParamNames(const clang::FunctionDecl *FD);
+
+/// Builds the diagnostic message for a swap found by the checker. The message
+/// is the same whichever frontend found the swap.
+std::string describeSwap(const swapped_arg::Result &R);
+
+/// Called for each call visited by forEachCallSite(), with the call, the
+/// function it calls, the arguments which are passed to the function's
+/// parameters, and the call site to check. The call site's arguments are the
+/// same as the given ones. The call is either a CallExpr or, for constructor
+/// calls, a CXXConstructExpr.
+using CallSiteCallback = llvm::function_ref<void(
+    const clang::Expr *Call, const clang::FunctionDecl *FD,
+    llvm::ArrayRef<const clang::Expr *> Args, swapped_arg::CallSite &CS)>;
+
+/// Visits every call to a known function or constructor in the translation
+/// unit, walking the AST rather than the paths through each function, so that
+/// each call expression is visited exactly once. Calls in templates are
+/// visited once per instantiation.
+void forEachCallSite(clang::ASTContext &Ctx, CallSiteCallback Fn);
+
+/// Called for each swap found by checkCalls(), with the call and the two
+/// swapped argument expressions.
+using SwapCallback = llvm::function_ref<void(
+    const clang::Expr *Call, const clang::Expr *Arg1, const clang::Expr *Arg2,
+    const swapped_arg::Result &R)>;
+
+/// Checks every call visited by forEachCallSite() for swapped arguments.
+void checkCalls(swapped_arg::Checker &Check, clang::ASTContext &Ctx,
+                SwapCallback Report);
+
+#endif // PLUGIN_CALLSITES_H
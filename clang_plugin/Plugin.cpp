@@ -24,6 +24,10 @@
 //   to the statistics database to be used by the tool. Defaults to not using a
 //   statistics database.
 //
+//   The hidden DumpCheckedCalls option prints the name of each callee to
+//   standard error whenever a call is actually checked, rather than reported
+//   from an earlier path. It is only meant for regression tests.
+//
 // gt.ExprNames
 //    Used to help test the expression name extraction functionality and is not
 //    likely to be useful in other contexts.
@@ -32,6 +36,15 @@
 //                   -enable-checker gt.SwapDetector
 //                   -analyzer-config gt.SwapDetector:ModelPath=sample.db
 //        clang <options> source_file
+//
+// The plugin also provides the swap-detector frontend action, which checks
+// each call once by walking the AST instead of running the analyzer, and
+// reports swaps as compiler warnings:
+//
+// Usage: clang -fplugin=SwapDetectorPlugin.so
+//              -Xclang -add-plugin -Xclang swap-detector
+//              -Xclang -plugin-arg-swap-detector -Xclang model=sample.db
+//              <options> source_file
 
 #include "ExprNamesInspectionChecker.hpp"
 #include "SwappedArgCheckerPlugin.hpp"
@@ -44,7 +57,10 @@ extern "C" const char clang_analyzerAPIVersionString[] =
 static void initializeSwappedArgChecker(CheckerManager &mgr) {
   StringRef modelPath = mgr.getAnalyzerOptions().getCheckerStringOption(
       "gt.SwapDetector", "ModelPath");
-  (void)mgr.registerChecker<SwappedArgChecker>(modelPath.str());
+  bool dumpCheckedCalls = mgr.getAnalyzerOptions().getCheckerBooleanOption(
+      "gt.SwapDetector", "DumpCheckedCalls");
+  (void)mgr.registerChecker<SwappedArgChecker>(modelPath.str(),
+                                               dumpCheckedCalls);
 }
 
 
@@ -53,6 +69,9 @@ static bool alwaysRegister(const LangOptions &) { return true; }
 extern "C" void clang_registerCheckers(CheckerRegistry &registry) {
   registry.addCheckerOption("string", "gt.SwapDetector", "ModelPath", "", "",
                             "alpha");
+  registry.addCheckerOption("bool", "gt.SwapDetector", "DumpCheckedCalls",
+                            "false", "Print each call as it is checked",
+                            "alpha", /*IsHidden=*/true);
   registry.addChecker(&initializeSwappedArgChecker, &alwaysRegister,
                       "gt.SwapDetector", "Check for swapped arguments", "",
                       false);
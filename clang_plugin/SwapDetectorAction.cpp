@@ -0,0 +1,181 @@
+//===- SwapDetectorAction.cpp -----------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#include "SwapDetectorAction.hpp"
+#include "CallSites.hpp"
+#include "SwappedArgChecker.hpp"
+#include <clang/AST/ASTConsumer.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendPluginRegistry.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace clang;
+
+namespace {
+class SwapDetectorConsumer : public ASTConsumer {
+  swapped_arg::Checker Check;
+
+public:
+  SwapDetectorConsumer(const std::string &ModelPath) : Check({ModelPath}) {}
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    DiagnosticsEngine &D = Ctx.getDiagnostics();
+    unsigned DiagID = D.getCustomDiagID(DiagnosticsEngine::Warning, "%0");
+    checkCalls(Check, Ctx,
+               [&](const Expr *Call, const Expr *Arg1, const Expr *Arg2,
+                   const swapped_arg::Result &R) {
+      D.Report(Call->getExprLoc(), DiagID)
+          << describeSwap(R) << Arg1->getSourceRange()
+          << Arg2->getSourceRange();
+    });
+  }
+};
+
+// Writes the call sites in a translation unit as one entry of a names
+// database, in the same shape as test/integration/names_subset.json.
+class ExtractCallSitesConsumer : public ASTConsumer {
+  std::string NamesPath;
+  std::string ProjectIdentifier;
+
+public:
+  ExtractCallSitesConsumer(std::string NamesPath,
+                           std::string ProjectIdentifier)
+      : NamesPath(std::move(NamesPath)),
+        ProjectIdentifier(std::move(ProjectIdentifier)) {}
+
+  void HandleTranslationUnit(ASTContext &Ctx) override;
+};
+
+void ExtractCallSitesConsumer::HandleTranslationUnit(ASTContext &Ctx) {
+  const SourceManager &SM = Ctx.getSourceManager();
+  llvm::json::Array FileNames;
+  llvm::StringMap<unsigned> FileIndexes;
+  auto location = [&](SourceLocation Loc) -> llvm::json::Value {
+    PresumedLoc PLoc = SM.getPresumedLoc(SM.getExpansionLoc(Loc));
+    if (PLoc.isInvalid())
+      return llvm::json::Object();
+    auto It = FileIndexes.try_emplace(PLoc.getFilename(), FileNames.size());
+    if (It.second)
+      FileNames.push_back(PLoc.getFilename());
+    return llvm::json::Object{{"file", It.first->second},
+                              {"lineNo", PLoc.getLine()}};
+  };
+  auto names = [](const std::vector<std::string> &Names) {
+    llvm::json::Array Ret;
+    for (const std::string &Name : Names)
+      Ret.push_back(llvm::json::Object{{"name", Name}});
+    return Ret;
+  };
+
+  // Overloads share a qualified name but not their parameters, so there is an
+  // entry for each function rather than each name. Entries are keyed by the
+  // name and the function's type, and carry the name itself separately. The
+  // type is not enough on its own to tell functions apart, as a template
+  // specialization may have the same type as a plain overload, so later
+  // functions with the same key are numbered.
+  llvm::json::Object Functions;
+  llvm::DenseMap<const FunctionDecl *, std::string> Keys;
+  forEachCallSite(Ctx, [&](const Expr *Call, const FunctionDecl *FD,
+                           llvm::ArrayRef<const Expr *>,
+                           swapped_arg::CallSite &CS) {
+    std::string &Key = Keys[FD->getCanonicalDecl()];
+    if (Key.empty()) {
+      std::string Base = CS.callDecl.fullyQualifiedName + " " +
+                         FD->getType().getAsString();
+      Key = Base;
+      for (unsigned Idx = 2; Functions.find(Key) != Functions.end(); ++Idx)
+        Key = Base + " #" + std::to_string(Idx);
+      Functions[Key] = llvm::json::Object{
+          {"callSites", llvm::json::Array()},
+          {"declAttrs",
+           llvm::json::Object{{"location", location(FD->getLocation())},
+                              {"params", names(*CS.callDecl.paramNames)}}},
+          {"name", CS.callDecl.fullyQualifiedName}};
+    }
+    llvm::json::Value &Func = Functions[Key];
+
+    // Each argument is named by a single identifier.
+    std::vector<std::string> Args;
+    for (const auto &Arg : CS.positionalArgNames)
+      Args.push_back(Arg.empty() ? std::string() : Arg.front());
+    Func.getAsObject()->getArray("callSites")->push_back(llvm::json::Object{
+        {"attrs", llvm::json::Object{{"args", names(Args)}}},
+        {"site", location(Call->getExprLoc())}});
+  });
+
+  llvm::json::Value Root = llvm::json::Object{
+      {"fileNameMap", std::move(FileNames)},
+      {"functions", std::move(Functions)},
+      {"projectIdentifier", ProjectIdentifier},
+      {"version", "1.1"}};
+  std::string Entry = llvm::formatv("{0}\n", Root).str();
+
+  // Many compiles may append to the same file at once, so the entry is
+  // written with a single unbuffered write to a file opened for appending,
+  // which keeps each line whole.
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(NamesPath, EC, llvm::sys::fs::OF_Append);
+  if (!EC) {
+    OS.SetUnbuffered();
+    OS << Entry;
+    OS.close();
+    EC = OS.error();
+    OS.clear_error();
+  }
+  if (EC) {
+    DiagnosticsEngine &D = Ctx.getDiagnostics();
+    D.Report(D.getCustomDiagID(DiagnosticsEngine::Error,
+                               "unable to write call sites to '%0': %1"))
+        << NamesPath << EC.message();
+  }
+}
+} // namespace
+
+std::unique_ptr<ASTConsumer>
+SwapDetectorAction::CreateASTConsumer(CompilerInstance &CI,
+                                      llvm::StringRef InFile) {
+  if (!NamesPath.empty())
+    return std::make_unique<ExtractCallSitesConsumer>(NamesPath, InFile.str());
+  return std::make_unique<SwapDetectorConsumer>(ModelPath);
+}
+
+bool SwapDetectorAction::ParseArgs(const CompilerInstance &CI,
+                                   const std::vector<std::string> &Args) {
+  for (const std::string &Arg : Args) {
+    llvm::StringRef Ref(Arg);
+    if (Ref.consume_front("model=")) {
+      ModelPath = Ref.str();
+      continue;
+    }
+    if (Ref.consume_front("names=")) {
+      NamesPath = Ref.str();
+      continue;
+    }
+    DiagnosticsEngine &D = CI.getDiagnostics();
+    D.Report(D.getCustomDiagID(DiagnosticsEngine::Error,
+                               "unknown swap-detector plugin argument '%0'"))
+        << Arg;
+    return false;
+  }
+  return true;
+}
+
+static FrontendPluginRegistry::Add<SwapDetectorAction>
+    X("swap-detector", "check calls for swapped arguments");
@@ -0,0 +1,48 @@
+//===- SwapDetectorAction.hpp -----------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#ifndef PLUGIN_SWAPDETECTORACTION_H
+#define PLUGIN_SWAPDETECTORACTION_H
+
+#include <clang/Frontend/FrontendAction.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// A frontend plugin action which checks every call in the translation unit
+/// for swapped arguments by walking the AST, without running the static
+/// analyzer. Each call expression is checked exactly once, regardless of how
+/// many paths reach it, and swaps are reported as plain warnings.
+///
+/// Accepts the optional plugin arguments:
+///   model=<path>  The statistics database to check against.
+///   names=<path>  Do not check anything; instead, append every call site in
+///                 the translation unit to the given file as a single line of
+///                 the names database format read by SwapDetectorBatch, so
+///                 the call sites can be checked later, and against any model.
+class SwapDetectorAction : public clang::PluginASTAction {
+  std::string ModelPath;
+  std::string NamesPath;
+
+protected:
+  std::unique_ptr<clang::ASTConsumer>
+  CreateASTConsumer(clang::CompilerInstance &CI,
+                    llvm::StringRef InFile) override;
+
+  bool ParseArgs(const clang::CompilerInstance &CI,
+                 const std::vector<std::string> &Args) override;
+};
+
+#endif // PLUGIN_SWAPDETECTORACTION_H
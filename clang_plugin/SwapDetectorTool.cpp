@@ -0,0 +1,179 @@
+//===- SwapDetectorTool.cpp -------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+
+// A standalone tool which checks every call in a project for swapped
+// arguments, using the compilation database written by the build (for
+// instance, with CMAKE_EXPORT_COMPILE_COMMANDS). Translation units are parsed
+// and checked in parallel, and every thread shares one Checker and so one
+// loaded model. Each call is checked once by walking the AST, as with the
+// plugin's swap-detector action, rather than by running the static analyzer.
+//
+// Usage: swap-detector -p <build directory> [options]
+//   Checks every file in the compilation database, or only those matching
+//   --filter=<regex>. Swaps are written to standard output once every
+//   translation unit has been checked, sorted by location, in the same format
+//   as compiler warnings. A call in a header is reported once no matter how
+//   many translation units include it.
+//
+// Options:
+//   --model=<path>     The statistics model to check against.
+//   --in-memory        Load the whole statistics model into memory.
+//   --threads=<count>  The number of translation units to check at once; zero,
+//                      the default, uses one thread for each hardware thread.
+
+#include "CallSites.hpp"
+#include "SwappedArgChecker.hpp"
+#include <clang/AST/ASTConsumer.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendAction.h>
+#include <clang/Tooling/AllTUsExecution.h>
+#include <clang/Tooling/CommonOptionsParser.h>
+#include <clang/Tooling/Tooling.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdlib>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+
+using namespace clang;
+using namespace clang::tooling;
+
+static llvm::cl::OptionCategory SwapDetectorCategory("swap-detector options");
+
+static llvm::cl::opt<std::string>
+    ModelPath("model", llvm::cl::desc("The statistics model to check against"),
+              llvm::cl::value_desc("path"),
+              llvm::cl::cat(SwapDetectorCategory));
+
+static llvm::cl::opt<bool>
+    InMemory("in-memory",
+             llvm::cl::desc("Load the whole statistics model into memory"),
+             llvm::cl::cat(SwapDetectorCategory));
+
+static llvm::cl::opt<unsigned>
+    Threads("threads",
+            llvm::cl::desc("The number of translation units to check at once "
+                           "(0 uses one per hardware thread)"),
+            llvm::cl::init(0), llvm::cl::cat(SwapDetectorCategory));
+
+namespace {
+// A swap found at a call. Ordered by location so that the output is stable
+// regardless of the order in which translation units finish.
+struct Finding {
+  std::string File;
+  unsigned Line, Column;
+  std::string Message;
+
+  bool operator<(const Finding &Other) const {
+    return std::tie(File, Line, Column, Message) <
+           std::tie(Other.File, Other.Line, Other.Column, Other.Message);
+  }
+};
+
+// The swaps found across all translation units. Calls in headers are seen by
+// every translation unit which includes them, so findings are kept in a set.
+class Findings {
+  std::mutex Lock;
+  std::set<Finding> All;
+
+public:
+  void add(Finding F) {
+    std::lock_guard<std::mutex> Guard(Lock);
+    All.insert(std::move(F));
+  }
+
+  const std::set<Finding> &all() const { return All; }
+};
+
+class CheckCallsConsumer : public ASTConsumer {
+  swapped_arg::Checker &Check;
+  Findings &Found;
+
+public:
+  CheckCallsConsumer(swapped_arg::Checker &Check, Findings &Found)
+      : Check(Check), Found(Found) {}
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    const SourceManager &SM = Ctx.getSourceManager();
+    checkCalls(Check, Ctx,
+               [&](const Expr *Call, const Expr *, const Expr *,
+                   const swapped_arg::Result &R) {
+      PresumedLoc Loc =
+          SM.getPresumedLoc(SM.getExpansionLoc(Call->getExprLoc()));
+      if (Loc.isInvalid())
+        return;
+      Found.add({Loc.getFilename(), Loc.getLine(), Loc.getColumn(),
+                 describeSwap(R)});
+    });
+  }
+};
+
+class CheckCallsAction : public ASTFrontendAction {
+  swapped_arg::Checker &Check;
+  Findings &Found;
+
+public:
+  CheckCallsAction(swapped_arg::Checker &Check, Findings &Found)
+      : Check(Check), Found(Found) {}
+
+  std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &,
+                                                 llvm::StringRef) override {
+    return std::make_unique<CheckCallsConsumer>(Check, Found);
+  }
+};
+
+class CheckCallsActionFactory : public FrontendActionFactory {
+  swapped_arg::Checker &Check;
+  Findings &Found;
+
+public:
+  CheckCallsActionFactory(swapped_arg::Checker &Check, Findings &Found)
+      : Check(Check), Found(Found) {}
+
+  std::unique_ptr<FrontendAction> create() override {
+    return std::make_unique<CheckCallsAction>(Check, Found);
+  }
+};
+} // namespace
+
+int main(int argc, const char **argv) {
+  auto Options = CommonOptionsParser::create(argc, argv, SwapDetectorCategory,
+                                             llvm::cl::ZeroOrMore);
+  if (!Options) {
+    llvm::errs() << llvm::toString(Options.takeError());
+    return EXIT_FAILURE;
+  }
+
+  swapped_arg::CheckerConfiguration Opts;
+  Opts.ModelPath = ModelPath;
+  Opts.LoadModelInMemory = InMemory;
+  swapped_arg::Checker Check(Opts);
+
+  Findings Found;
+  AllTUsToolExecutor Executor(Options->getCompilations(), Threads);
+  if (llvm::Error Err = Executor.execute(
+          std::make_unique<CheckCallsActionFactory>(Check, Found))) {
+    llvm::errs() << llvm::toString(std::move(Err)) << "\n";
+    return EXIT_FAILURE;
+  }
+
+  for (const Finding &F : Found.all())
+    llvm::outs() << F.File << ":" << F.Line << ":" << F.Column
+                 << ": warning: " << F.Message << "\n";
+  return EXIT_SUCCESS;
+}
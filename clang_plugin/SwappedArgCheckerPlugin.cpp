@@ -14,23 +14,12 @@
 //
 //===----------------------------------------------------------------------===//
 #include "SwappedArgCheckerPlugin.hpp"
+#include "CallSites.hpp"
 #include "ExprNames.hpp"
 #include <clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h>
 #include <clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h>
 #include <clang/StaticAnalyzer/Core/PathSensitive/CheckerHelpers.h>
-#include <experimental/iterator>
-#include <iterator>
-#include <llvm/ADT/STLExtras.h>
-#include <sstream>
-
-static std::vector<std::string> getParamNames(const FunctionDecl *FD) {
-  std::vector<std::string> Ret;
-  llvm::transform(FD->parameters(), std::back_inserter(Ret),
-                  [](const ParmVarDecl *PVD) {
-    return PVD->getName().str();
-  });
-  return Ret;
-}
+#include <llvm/Support/raw_ostream.h>
 
 static std::vector<swapped_arg::CallSite::ArgumentNames>
 getArgNames(const CallEvent &Call, CheckerContext &Ctx) {
@@ -46,39 +35,68 @@ getArgNames(const CallEvent &Call, CheckerContext &Ctx) {
   return Ret;
 }
 
-static std::string flattenMorphemeListForDiag(const std::set<std::string> &M) {
-  std::ostringstream OS;
-  std::copy(M.begin(), M.end(),
-            std::experimental::make_ostream_joiner(OS, ", "));
-  return OS.str();
+const SwappedArgChecker::Callee &
+SwappedArgChecker::getCallee(const FunctionDecl *FD) const {
+  auto It = Callees.find(FD);
+  if (It != Callees.end())
+    return It->second;
+
+  Callee &New = Callees[FD];
+  New.QualifiedName = FD->getQualifiedNameAsString();
+  New.ParamNames = getParamNames(FD);
+  size_t NamedParams = llvm::count_if(
+      New.ParamNames, [](const std::string &Name) { return !Name.empty(); });
+  New.Checkable =
+      NamedParams >= 2 || Check.mayHaveStatistics(New.QualifiedName);
+  return New;
 }
 
 void SwappedArgChecker::checkPreCall(const CallEvent &Call,
                                      CheckerContext &C) const {
+  // No swap is possible with fewer than two arguments.
+  if (Call.getNumArgs() < 2)
+    return;
   auto *FD = dyn_cast_or_null<FunctionDecl>(Call.getDecl());
   if (!FD)
     return;
+  const Callee &Info = getCallee(FD);
+  if (!Info.Checkable)
+    return;
 
-  using namespace swapped_arg;
-  CallDeclDescriptor CDD;
-  CDD.fullyQualifiedName = FD->getQualifiedNameAsString();
-  CDD.paramNames = getParamNames(FD);
+  // If this call was already checked on another path, report the same swaps
+  // again without checking it again. Calls without an expression, such as
+  // implicit destructor calls, are not remembered.
+  const Expr *Origin = Call.getOriginExpr();
+  if (Origin) {
+    auto It = Verdicts.find({Origin, FD});
+    if (It != Verdicts.end()) {
+      for (const Finding &F : It->second)
+        reportRuleViolation(Call, C, F.Arg1, F.Arg2, F.Message);
+      return;
+    }
+  }
 
+  using namespace swapped_arg;
   CallSite CS;
-  CS.callDecl = CDD;
+  CS.callDecl.fullyQualifiedName = Info.QualifiedName;
+  CS.callDecl.paramNames = Info.ParamNames;
   CS.positionalArgNames = getArgNames(Call, C);
 
-  std::vector<Result> Results = Check.CheckSite(CS);
-  for (const auto &R : Results) {
-    std::string Msg =
-        ("arguments " + Twine(R.arg1) + " and " + Twine(R.arg2) +
-         " are swapped with morpheme1 = " +
-         flattenMorphemeListForDiag(R.morphemes1) +
-         " and morpheme2 = " + flattenMorphemeListForDiag(R.morphemes2))
-            .str();
+  if (DumpCheckedCalls)
+    llvm::errs() << "gt.SwapDetector: checking call to '"
+                 << Info.QualifiedName << "'\n";
+
+  std::vector<Finding> Found;
+  Check.CheckSite(CS, [&](const Result &R) {
     // Expects zero-based argument indexes, hence the -1.
-    reportRuleViolation(Call, C, R.arg1 - 1, R.arg2 - 1, Msg);
-  }
+    Found.push_back({R.arg1 - 1, R.arg2 - 1, describeSwap(R)});
+    return true;
+  });
+
+  for (const Finding &F : Found)
+    reportRuleViolation(Call, C, F.Arg1, F.Arg2, F.Message);
+  if (Origin)
+    Verdicts[{Origin, FD}] = std::move(Found);
 }
 
 void SwappedArgChecker::reportRuleViolation(const CallEvent &Call,
@@ -101,5 +119,6 @@ void SwappedArgChecker::reportRuleViolation(const CallEvent &Call,
   }
 }
 
-SwappedArgChecker::SwappedArgChecker(const std::string &modelPath)
-    : Check({modelPath}) {}
+SwappedArgChecker::SwappedArgChecker(const std::string &modelPath,
+                                     bool dumpCheckedCalls)
+    : Check({modelPath}), DumpCheckedCalls(dumpCheckedCalls) {}
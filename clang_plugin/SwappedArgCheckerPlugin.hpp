@@ -19,6 +19,7 @@
 #include <clang/StaticAnalyzer/Core/BugReporter/BugReporter.h>
 #include <clang/StaticAnalyzer/Core/BugReporter/BugType.h>
 #include <clang/StaticAnalyzer/Core/Checker.h>
+#include <llvm/ADT/DenseMap.h>
 #include "SwappedArgChecker.hpp"
 
 using namespace clang;
@@ -27,6 +28,34 @@ using namespace clang::ento;
 class SwappedArgChecker : public Checker<check::PreCall> {
   mutable swapped_arg::Checker Check;
   mutable std::unique_ptr<BugType> BT;
+  // Whether to print each callee as its call is checked, for testing.
+  bool DumpCheckedCalls;
+
+  // A swap found at a call, with zero-based argument indexes.
+  struct Finding {
+    size_t Arg1, Arg2;
+    std::string Message;
+  };
+  // The swaps found at each call which has been checked, keyed by the call
+  // expression and the function it calls. The analyzer visits a call once for
+  // every path through it, but the call site is the same each time, so it is
+  // only checked on the first visit.
+  mutable llvm::DenseMap<std::pair<const Expr *, const FunctionDecl *>,
+                         std::vector<Finding>>
+      Verdicts;
+
+  // What is needed to check calls to a function, computed once for each
+  // function declaration.
+  struct Callee {
+    std::string QualifiedName;
+    std::vector<std::string> ParamNames;
+    // False if no check can find a swap at any call to the function, because
+    // it has fewer than two named parameters and no statistics in the model.
+    bool Checkable = false;
+  };
+  mutable llvm::DenseMap<const FunctionDecl *, Callee> Callees;
+
+  const Callee &getCallee(const FunctionDecl *FD) const;
 
   friend class check::PreCall;
   void checkPreCall(const CallEvent &Call, CheckerContext &C) const;
@@ -35,7 +64,8 @@ class SwappedArgChecker : public Checker<check::PreCall> {
                            size_t Arg2, llvm::StringRef Message) const;
 
 public:
-  SwappedArgChecker(const std::string &modelPath);
+  SwappedArgChecker(const std::string &modelPath,
+                    bool dumpCheckedCalls = false);
 };
 
 #endif // PLUGIN_SWAPPEDARGCHECKERPLUGIN_H
@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -add-plugin swap-detector -plugin-arg-swap-detector model=%S/test.db -verify %s
+// REQUIRES: plugins
+
+void func(int, int);
+
+int main(void) {
+  int dogs = 1, cats = 2;
+  // Both branches lead to the same call, which is only reported once.
+  if (dogs > cats)
+    dogs = cats;
+  func(dogs, cats); // expected-warning {{arguments 1 and 2 are swapped with morpheme1 = dogs and morpheme2 = cats}}
+}
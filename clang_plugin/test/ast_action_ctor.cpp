@@ -0,0 +1,22 @@
+// RUN: %clang_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -add-plugin swap-detector -verify %s
+// REQUIRES: plugins
+
+struct Rect {
+  Rect(int width, int height);
+};
+
+struct Span {
+  Span(int dst, int src);
+};
+
+void use(const Rect &);
+
+// Constructor calls are not CallExprs, but are checked all the same, however
+// the object is constructed.
+void construct(int width, int height, int dst, int src) {
+  Rect R(height, width); // expected-warning {{arguments 1 and 2 are swapped with morpheme1 = height and morpheme2 = width}}
+  Rect *P = new Rect(height, width); // expected-warning {{arguments 1 and 2 are swapped with morpheme1 = height and morpheme2 = width}}
+  use(Rect(height, width)); // expected-warning {{arguments 1 and 2 are swapped with morpheme1 = height and morpheme2 = width}}
+  Span S(dst, src);
+  delete P;
+}
@@ -0,0 +1,17 @@
+// RUN: rm -f %t.json
+// RUN: %clang_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -add-plugin swap-detector -plugin-arg-swap-detector names=%t.json %s
+// RUN: %clang_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -add-plugin swap-detector -plugin-arg-swap-detector names=%t.json %s
+// RUN: FileCheck %s < %t.json
+// REQUIRES: plugins
+
+void func(int dogs, int cats);
+
+int main(void) {
+  int dogs = 1, cats = 2;
+  func(cats, dogs);
+}
+
+// Each compile appends one entry, and nothing is checked.
+// CHECK: {"fileNameMap":["{{.*}}extract.c"],"functions":{"func void (int, int)":{"callSites":[{"attrs":{"args":[{"name":"cats"},{"name":"dogs"}]},"site":{"file":0,"lineNo":11}}],"declAttrs":{"location":{"file":0,"lineNo":7},"params":[{"name":"dogs"},{"name":"cats"}]},"name":"func"}},"projectIdentifier":"{{.*}}extract.c","version":"1.1"}
+// CHECK-NEXT: {"fileNameMap":["{{.*}}extract.c"],{{.*}}"version":"1.1"}{{$}}
+// CHECK-NOT: {{.}}
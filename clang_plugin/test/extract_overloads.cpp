@@ -0,0 +1,19 @@
+// RUN: rm -f %t.json
+// RUN: %clang_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -add-plugin swap-detector -plugin-arg-swap-detector names=%t.json %s
+// RUN: FileCheck %s < %t.json
+// REQUIRES: plugins
+
+void f(int width, int height);
+void f(int src, int dst, int len);
+
+void g(int width, int height, int src, int dst, int len) {
+  f(height, width);
+  f(src, dst, len);
+  f(width, height);
+}
+
+// Each overload gets its own entry, with its own parameters and only its own
+// call sites, so they are not checked against each other's parameters.
+// CHECK: "functions":{
+// CHECK-SAME: "f void (int, int)":{"callSites":[{"attrs":{"args":[{"name":"height"},{"name":"width"}]},"site":{"file":0,"lineNo":10}},{"attrs":{"args":[{"name":"width"},{"name":"height"}]},"site":{"file":0,"lineNo":12}}],"declAttrs":{"location":{"file":0,"lineNo":6},"params":[{"name":"width"},{"name":"height"}]},"name":"f"},
+// CHECK-SAME: "f void (int, int, int)":{"callSites":[{"attrs":{"args":[{"name":"src"},{"name":"dst"},{"name":"len"}]},"site":{"file":0,"lineNo":11}}],"declAttrs":{"location":{"file":0,"lineNo":7},"params":[{"name":"src"},{"name":"dst"},{"name":"len"}]},"name":"f"}},
@@ -0,0 +1,22 @@
+// RUN: %clang_analyze_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -analyzer-checker=gt.SwapDetector -verify %s
+// RUN: %clang_analyze_cc1 -load %llvmshlibdir/SwapDetectorPlugin%shlibext -analyzer-checker=gt.SwapDetector -analyzer-config gt.SwapDetector:DumpCheckedCalls=true %s 2>&1 | FileCheck %s --implicit-check-not="checking call"
+// REQUIRES: plugins
+
+void func(int cats, int dogs);
+void other(int horses, int emus);
+
+// Each call is reached along several paths, but is only checked on the first
+// one to reach it, which checks func before other.
+// CHECK: gt.SwapDetector: checking call to 'func'
+// CHECK: gt.SwapDetector: checking call to 'other'
+void branchy(int a, int b, int c) {
+  int dogs = 1, cats = 2, horses = 3, emus = 4;
+  if (a)
+    dogs++;
+  if (b)
+    cats++;
+  if (c)
+    dogs--;
+  func(dogs, cats); // expected-warning {{arguments 1 and 2 are swapped with morpheme1 = dogs and morpheme2 = cats}}
+  other(horses, emus);
+}
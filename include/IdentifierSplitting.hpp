@@ -16,17 +16,61 @@
 #ifndef GT_SWAPPED_ARG_IDENTIFIER_SPLITTING_H
 #define GT_SWAPPED_ARG_IDENTIFIER_SPLITTING_H
 
+#include "MorphemeInterner.hpp"
+#include <atomic>
+#include <functional>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace swapped_arg {
 class IdentifierSplitter {
 public:
+  // Creates a splitter which does not remember any of its results.
+  IdentifierSplitter() = default;
+  // Creates a splitter which remembers the interned morphemes for up to
+  // memoCapacity identifiers, so identifiers that are seen repeatedly are only
+  // split once. This is safe to share between threads.
+  explicit IdentifierSplitter(size_t memoCapacity)
+      : MemoCapacity(memoCapacity) {}
+
   // Returns a set of case-insensitive, unique morphemes for the identifier.
   // e.g., foo_barBaz_bar would result in a set [foo, bar, baz], not
   // [foo, bar, Baz, bar].
   std::set<std::string> split(const std::string& input) const;
+
+  // Splits the identifier the same way as above, but returns the morphemes as
+  // identifiers from the given interner. Results are only remembered for the
+  // first interner the splitter is used with.
+  MorphemeIdSet split(const std::string& input,
+                      MorphemeInterner& interner) const;
+
+  // The number of split() calls which were answered from, or were not found
+  // in, the remembered results.
+  size_t memoHits() const { return MemoHits; }
+  size_t memoMisses() const { return MemoMisses; }
+
+private:
+  size_t MemoCapacity = 0;
+  mutable std::shared_mutex MemoLock;
+  mutable const MorphemeInterner* MemoInterner = nullptr;
+  mutable std::unordered_map<std::string, MorphemeIdSet> Memo;
+  mutable std::atomic<size_t> MemoHits{0}, MemoMisses{0};
 };
+
+namespace test {
+// These interfaces only exist so that unit tests and benchmarks can compare the
+// two ways identifiers are split, and should not be used by production code.
+// Each calls fn with every lowercased word in the identifier, in order and
+// including any repeated words.
+void forEachWordScalar(const std::string& input,
+                       const std::function<void(std::string_view)>& fn);
+// Returns false without calling fn if the identifier is not entirely ASCII.
+bool forEachWordAscii(const std::string& input,
+                      const std::function<void(std::string_view)>& fn);
+} // end namespace test
 } // end namespace swapped_arg
 
 #endif // GT_SWAPPED_ARG_IDENTIFIER_SPLITTING_H
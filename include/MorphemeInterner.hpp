@@ -0,0 +1,260 @@
+//===- MorphemeInterner.hpp -------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_SWAPPED_ARG_MORPHEME_INTERNER_H
+#define GT_SWAPPED_ARG_MORPHEME_INTERNER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace swapped_arg {
+// Maps morphemes to small integer identifiers so that they can be stored,
+// compared, and hashed cheaply. Identifiers are dense, starting from zero, and
+// remain valid for the lifetime of the interner. All member functions may be
+// called concurrently from multiple threads.
+class MorphemeInterner {
+public:
+  using Id = uint32_t;
+
+  // Returns the identifier for the given morpheme, assigning a new one if the
+  // morpheme has not been seen before.
+  Id intern(std::string_view morpheme);
+
+  // Returns the identifier for the given morpheme, or nullopt if the morpheme
+  // has never been interned.
+  std::optional<Id> find(std::string_view morpheme) const;
+
+  // Returns the morpheme with the given identifier, which must have been
+  // returned by this interner.
+  const std::string& str(Id id) const;
+
+  // Returns the number of distinct morphemes interned so far.
+  size_t size() const;
+
+private:
+  mutable std::shared_mutex Lock;
+  // A deque so that the strings never move, which keeps the views used as the
+  // keys of Ids valid.
+  std::deque<std::string> Strings;
+  std::unordered_map<std::string_view, Id> Ids;
+};
+
+// A set of interned morphemes, kept as a sorted vector of identifiers. An
+// identifier splits into only a handful of morphemes, so small sets are stored
+// inline without allocating, and set operations are linear merges over the
+// identifiers. Note that the sort order is by identifier, not by the text of
+// the morphemes.
+class MorphemeIdSet {
+public:
+  using Id = MorphemeInterner::Id;
+  using value_type = Id;
+  using size_type = size_t;
+  using const_reference = const Id&;
+  using const_iterator = const Id*;
+  using iterator = const_iterator;
+
+  MorphemeIdSet() = default;
+  MorphemeIdSet(std::initializer_list<Id> ids) {
+    for (Id id : ids)
+      insert(id);
+  }
+
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + Count; }
+  size_t size() const { return Count; }
+  bool empty() const { return Count == 0; }
+
+  bool contains(Id id) const { return std::binary_search(begin(), end(), id); }
+
+  // Returns a 64-bit summary of the set, with one bit set for each identifier
+  // in it. If a bit of one set's signature is missing from another set's
+  // signature, the first set cannot be a subset of the other.
+  uint64_t signature() const {
+    uint64_t sig = 0;
+    for (Id id : *this)
+      sig |= uint64_t(1) << ((id * 0x9E3779B97F4A7C15ull) >> 58);
+    return sig;
+  }
+
+  // Removes every identifier, keeping any memory already allocated for reuse.
+  void clear() {
+    Count = 0;
+    Heap.clear();
+  }
+
+  // Adds the identifier to the set if it is not already present.
+  void insert(Id id) {
+    const_iterator pos = std::lower_bound(begin(), end(), id);
+    if (pos != end() && *pos == id)
+      return;
+    size_t idx = pos - begin();
+    if (Count == InlineCapacity)
+      Heap.assign(Inline, Inline + InlineCapacity);
+    if (Count >= InlineCapacity) {
+      Heap.insert(Heap.begin() + idx, id);
+    } else {
+      std::copy_backward(Inline + idx, Inline + Count, Inline + Count + 1);
+      Inline[idx] = id;
+    }
+    ++Count;
+  }
+
+  // Returns the identifiers in lhs which are not in rhs.
+  static MorphemeIdSet difference(const MorphemeIdSet& lhs,
+                                  const MorphemeIdSet& rhs) {
+    MorphemeIdSet ret;
+    std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                        Appender{ret});
+    return ret;
+  }
+
+  friend bool operator==(const MorphemeIdSet& lhs, const MorphemeIdSet& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+  }
+  friend bool operator!=(const MorphemeIdSet& lhs, const MorphemeIdSet& rhs) {
+    return !(lhs == rhs);
+  }
+
+private:
+  static constexpr size_t InlineCapacity = 6;
+
+  // An output iterator which appends identifiers that are already known to be
+  // larger than any in the set.
+  struct Appender {
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+
+    MorphemeIdSet& Set;
+    Appender& operator*() { return *this; }
+    Appender& operator++() { return *this; }
+    Appender& operator++(int) { return *this; }
+    Appender& operator=(Id id) {
+      Set.append(id);
+      return *this;
+    }
+  };
+
+  void append(Id id) {
+    if (Count == InlineCapacity)
+      Heap.assign(Inline, Inline + InlineCapacity);
+    if (Count >= InlineCapacity)
+      Heap.push_back(id);
+    else
+      Inline[Count] = id;
+    ++Count;
+  }
+
+  const Id* data() const {
+    return Count > InlineCapacity ? Heap.data() : Inline;
+  }
+
+  size_t Count = 0;
+  Id Inline[InlineCapacity] = {};
+  // Only used once the set outgrows the inline storage.
+  std::vector<Id> Heap;
+};
+
+// A set of interned morphemes together with the interner that knows their
+// text, so that the morphemes can be handed out without copying any strings.
+// Iterating over the list visits the text of each morpheme, in the order of
+// their identifiers. A list is only valid for as long as its interner is.
+class MorphemeList {
+public:
+  using value_type = std::string;
+  using size_type = size_t;
+  using const_reference = const std::string&;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string*;
+    using reference = const std::string&;
+
+    const_iterator() = default;
+
+    reference operator*() const { return Interner->str(*Pos); }
+    pointer operator->() const { return &**this; }
+    const_iterator& operator++() {
+      ++Pos;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator ret = *this;
+      ++Pos;
+      return ret;
+    }
+
+    friend bool operator==(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      return lhs.Pos == rhs.Pos;
+    }
+    friend bool operator!=(const const_iterator& lhs,
+                           const const_iterator& rhs) {
+      return lhs.Pos != rhs.Pos;
+    }
+
+  private:
+    friend class MorphemeList;
+    const_iterator(MorphemeIdSet::const_iterator pos,
+                   const MorphemeInterner* interner)
+        : Pos(pos), Interner(interner) {}
+
+    MorphemeIdSet::const_iterator Pos = nullptr;
+    const MorphemeInterner* Interner = nullptr;
+  };
+  using iterator = const_iterator;
+
+  MorphemeList() = default;
+  MorphemeList(MorphemeIdSet ids, const MorphemeInterner& interner)
+      : Ids(std::move(ids)), Interner(&interner) {}
+
+  const_iterator begin() const { return {Ids.begin(), Interner}; }
+  const_iterator end() const { return {Ids.end(), Interner}; }
+  size_t size() const { return Ids.size(); }
+  bool empty() const { return Ids.empty(); }
+
+  // The identifiers of the morphemes, as assigned by the interner.
+  const MorphemeIdSet& ids() const { return Ids; }
+
+  // Returns true if the given morpheme is in the list.
+  bool contains(std::string_view morpheme) const {
+    if (!Interner)
+      return false;
+    std::optional<MorphemeInterner::Id> id = Interner->find(morpheme);
+    return id && Ids.contains(*id);
+  }
+
+private:
+  MorphemeIdSet Ids;
+  const MorphemeInterner* Interner = nullptr;
+};
+} // end namespace swapped_arg
+
+#endif // GT_SWAPPED_ARG_MORPHEME_INTERNER_H
@@ -0,0 +1,42 @@
+//===- StatisticsModel.hpp --------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_SWAPPED_ARG_STATISTICS_MODEL_H
+#define GT_SWAPPED_ARG_STATISTICS_MODEL_H
+
+#include <string>
+
+// Utilities for maintaining the statistics model files consumed by the checker
+// through CheckerConfiguration::ModelPath.
+namespace swapped_arg {
+namespace model {
+// Converts the SQLite statistics model at sqlitePath into the compact,
+// memory-mappable binary model format and writes it to binaryPath. Both the
+// normalized schema (a weights view over weights_data and strings) and the
+// flat weights table are supported. Returns true on success; on failure,
+// returns false and sets error to a description of the problem.
+bool convertToBinary(const std::string& sqlitePath,
+                     const std::string& binaryPath, std::string& error);
+
+// Prepares the SQLite statistics model at sqlitePath for fast lookups by
+// creating a covering index for the checker's queries if it is missing, and by
+// refreshing the query planner's statistics. The model is modified in place.
+// Returns true on success; on failure, returns false and sets error to a
+// description of the problem.
+bool optimize(const std::string& sqlitePath, std::string& error);
+} // end namespace model
+} // end namespace swapped_arg
+
+#endif // GT_SWAPPED_ARG_STATISTICS_MODEL_H
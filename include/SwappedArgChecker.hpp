@@ -16,19 +16,27 @@
 #ifndef GT_SWAPPED_ARG_CHECKER_H
 #define GT_SWAPPED_ARG_CHECKER_H
 
+#include "IdentifierSplitting.hpp"
+#include "MorphemeInterner.hpp"
 #include <algorithm>
+#include <atomic>
 #include <initializer_list>
 #include <memory>
+#include <mutex>
 #include <optional>
-#include <set>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
 struct sqlite3;
 struct sqlite3_stmt;
 
 namespace swapped_arg {
+class CalleeStatistics;
 class Statistics;
 
 // A description of a function being called.
@@ -53,39 +61,20 @@ public:
   std::vector<ArgumentNames> positionalArgNames;
 };
 
-// Basic functionality to represent a score card from a failing check result.
-class ScoreCard {
-public:
-  // What kind of checking strategies are supported.
-  enum CheckerKind {
-    ParameterNameBased,
-    UsageStatisticsBased,
-  };
-
-  virtual ~ScoreCard() = default;
-
-  // The checker's confidence in this being a true positive, 0-100. Tools
-  // can map this value to be in their "native" range.
-  virtual float score() const = 0;
-
-  // The kind of checker the score card provides results for.
-  virtual CheckerKind kind() const = 0;
-};
-
-class ParameterNameBasedScoreCard : public ScoreCard {
+class ParameterNameBasedScoreCard {
   float Score;
   std::optional<float> StatsVettedScore;
 
 public:
-  explicit ParameterNameBasedScoreCard(float score, std::optional<float> statsVettedScore)
+  explicit ParameterNameBasedScoreCard(float score,
+                                       std::optional<float> statsVettedScore)
       : Score(score), StatsVettedScore(statsVettedScore) {}
-  CheckerKind kind() const override { return ParameterNameBased; }
-  float score() const override { return Score; }
+  float score() const { return Score; }
   bool vettedWithStats() const { return StatsVettedScore.has_value(); }
   float statsVettedScore() const { return *StatsVettedScore; }
 };
 
-class UsageStatisticsBasedScoreCard : public ScoreCard {
+class UsageStatisticsBasedScoreCard {
   float Fit1, Fit2;
   float Psi1, Psi2;
 
@@ -93,9 +82,7 @@ public:
   explicit UsageStatisticsBasedScoreCard(float fit1, float fit2, float psi1,
                                          float psi2)
       : Fit1(fit1), Fit2(fit2), Psi1(psi1), Psi2(psi2) {}
-  CheckerKind kind() const override { return UsageStatisticsBased; }
-
-  float score() const override { return std::max(Fit1, Fit2); }
+  float score() const { return std::max(Fit1, Fit2); }
 
   float arg1_fitness() const { return Fit1; }
   float arg2_fitness() const { return Fit2; }
@@ -104,7 +91,66 @@ public:
   float arg2_psi() const { return Psi2; }
 };
 
-// A swapped argument error.
+class ParameterNameRotationBasedScoreCard {
+  float Score;
+  std::vector<size_t> Rotation;
+
+public:
+  explicit ParameterNameRotationBasedScoreCard(float score,
+                                               std::vector<size_t> rotation)
+      : Score(score), Rotation(std::move(rotation)) {}
+  float score() const { return Score; }
+
+  // The one-based indices of the rotated arguments. The argument at each of
+  // these positions belongs at the next position, and the last argument
+  // belongs at the first position.
+  const std::vector<size_t>& rotation() const { return Rotation; }
+};
+
+// The score card from a failing check result, holding the details specific to
+// the kind of checker which produced it. Score cards are plain values, so they
+// can be created and copied without allocating.
+class ScoreCard {
+public:
+  // What kind of checking strategies are supported.
+  enum CheckerKind {
+    ParameterNameBased,
+    UsageStatisticsBased,
+    ParameterNameRotationBased,
+  };
+
+  // The details for each kind of checker, in the same order as CheckerKind.
+  using Card =
+      std::variant<ParameterNameBasedScoreCard, UsageStatisticsBasedScoreCard,
+                   ParameterNameRotationBasedScoreCard>;
+
+  ScoreCard(ParameterNameBasedScoreCard card) : Value(std::move(card)) {}
+  ScoreCard(UsageStatisticsBasedScoreCard card) : Value(std::move(card)) {}
+  ScoreCard(ParameterNameRotationBasedScoreCard card)
+      : Value(std::move(card)) {}
+
+  // The checker's confidence in this being a true positive, 0-100. Tools
+  // can map this value to be in their "native" range.
+  float score() const {
+    return std::visit([](const auto& card) { return card.score(); }, Value);
+  }
+
+  // The kind of checker the score card provides results for.
+  CheckerKind kind() const { return static_cast<CheckerKind>(Value.index()); }
+
+  // Returns the details of the score card if it is of the given kind, or
+  // nullptr otherwise.
+  template <typename CardTy> const CardTy* getAs() const {
+    return std::get_if<CardTy>(&Value);
+  }
+  const Card& card() const { return Value; }
+
+private:
+  Card Value;
+};
+
+// A swapped argument error. The morphemes refer to the Checker which produced
+// the result, so a result must not outlive its Checker.
 class Result {
 public:
   // Indices of the swapped arguments. Integer argument indexes are one-based.
@@ -112,14 +158,44 @@ public:
   size_t arg2;
 
   // The specific morphemes in each argument that were swapped.
-  std::set<std::string> morphemes1, morphemes2;
+  MorphemeList morphemes1, morphemes2;
 
-  std::unique_ptr<ScoreCard> score;
+  ScoreCard score;
+};
+
+// A reference to a callable which receives each swap found by
+// Checker::CheckSite() and returns false to stop checking. The sink does not
+// own the callable, so it is only suitable for passing as a parameter.
+class ResultSink {
+public:
+  template <typename Fn,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::decay_t<Fn>, ResultSink> &&
+                std::is_invocable_r_v<bool, Fn&, Result&&>>>
+  ResultSink(Fn&& fn)
+      : Callable(const_cast<void*>(
+            static_cast<const void*>(std::addressof(fn)))),
+        Callback([](void* callable, Result&& result) -> bool {
+          return (*static_cast<std::remove_reference_t<Fn>*>(callable))(
+              std::move(result));
+        }) {}
+
+  bool operator()(Result&& result) const {
+    return Callback(Callable, std::move(result));
+  }
+
+private:
+  void* Callable;
+  bool (*Callback)(void*, Result&&);
 };
 
 struct CheckerConfiguration {
   // Filesystem-native path to the model database.
   std::string ModelPath;
+  // When true, the entire model is read into memory when the Checker is
+  // constructed and all statistics lookups are answered without querying the
+  // database. This trades startup time and memory for faster checking.
+  bool LoadModelInMemory = false;
   // Comparison values used after calculating the match liklihood for either
   // pessimistic or optimistic matching, respectively.
   float ExistingMorphemeMatchMax = 0.5f;
@@ -133,16 +209,89 @@ struct CheckerConfiguration {
   // Comparison value used to determine whether a potential cover based swap
   // should be suppressed due to stats vetting.
   float CoverSwappedStatsVettingThreshold = 0.75f; // FIXME: made up number!!
+  // The maximum number of callees whose statistics are kept around for reuse
+  // by later call sites. Zero disables the cache.
+  size_t CalleeCacheCapacity = 4096;
+  // The maximum number of variadic arguments (those past the end of the
+  // callee's parameter list) to check at each call site. Any further variadic
+  // arguments are ignored. When unset, every argument is checked.
+  std::optional<size_t> MaxVariadicArguments;
+  // When true, the cover-based checker also looks for three or more arguments
+  // which have been rotated out of place, by finding the best assignment of
+  // the arguments to the parameters at each call site. Rotations are reported
+  // with a ParameterNameRotationBasedScoreCard; arg1 and arg2 are the first
+  // two arguments of the rotation.
+  bool DetectRotations = false;
+  // The maximum number of callee declarations whose split parameter names are
+  // kept around for reuse by later call sites. Zero disables the cache.
+  size_t DeclCacheCapacity = 4096;
+  // The maximum number of identifiers whose morphemes are remembered for reuse
+  // by later call sites. Zero disables remembering them.
+  size_t IdentifierMemoCapacity = 16384;
 };
 
+// Running totals describing the work done by a Checker, for diagnosing the
+// cost of checking.
+struct CheckerCounters {
+  // The number of times the statistics model was queried for a callee.
+  size_t CalleeLookups = 0;
+  // The number of callee lookups which found no statistics for the callee.
+  size_t EmptyCalleeLookups = 0;
+  // The number of callee lookups which were avoided because the model is known
+  // to have no statistics for the callee.
+  size_t SkippedCalleeLookups = 0;
+  // The number of callee lookups which were answered from the Checker's cache
+  // of callee statistics.
+  size_t CachedCalleeLookups = 0;
+  // The number of call sites whose callee declaration had its parameters
+  // split, or was found in the Checker's cache of split declarations.
+  size_t DeclarationLookups = 0;
+  size_t CachedDeclarationLookups = 0;
+  // The number of identifiers whose morphemes were found in, or were missing
+  // from, the Checker's memo of split identifiers.
+  size_t IdentifierMemoHits = 0;
+  size_t IdentifierMemoMisses = 0;
+  // The number of argument pairs given to the cover-based checker, and how
+  // many of those were rejected from their morpheme signatures alone, without
+  // comparing their morphemes.
+  size_t CoverPairs = 0;
+  size_t PrunedCoverPairs = 0;
+  // The number of times the morphemes of a whole argument were matched against
+  // those of a whole parameter for the cover-based and rotation checks.
+  size_t SiteMatches = 0;
+};
 
 class Checker {
   CheckerConfiguration Opts;
-  // Note: this is a pointer because it's an incomplete type, but not a
-  // unique_ptr because that would require the type to be complete for sizeof
-  // calculations in template instantiations (such as ones made by the CSA
-  // plugin).
-  Statistics* Stats = nullptr;
+  // The loaded model, which is shared with any other Checker using the same
+  // model file. Note: this is a shared_ptr rather than a unique_ptr because
+  // the type is incomplete, and unique_ptr would require the type to be
+  // complete for sizeof calculations in template instantiations (such as ones
+  // made by the CSA plugin).
+  std::shared_ptr<const Statistics> Stats;
+
+  std::atomic<size_t> CalleeLookups{0}, EmptyCalleeLookups{0},
+      SkippedCalleeLookups{0}, CachedCalleeLookups{0}, DeclarationLookups{0},
+      CachedDeclarationLookups{0}, CoverPairs{0}, PrunedCoverPairs{0},
+      SiteMatches{0};
+
+  // Morphemes from call sites and from the statistics model are identified by
+  // this interner.
+  MorphemeInterner Morphemes;
+  IdentifierSplitter Splitter;
+
+  // Statistics for recently checked callees, by fully qualified name. Each
+  // entry records how many argument positions were fetched.
+  std::mutex CalleeCacheLock;
+  std::unordered_map<std::string,
+                     std::pair<size_t, std::shared_ptr<const CalleeStatistics>>>
+      CalleeCache;
+
+  // Fetches the statistics for the callee at the first argCount argument
+  // positions, reusing a cached copy if there is one. Returns nullptr if there
+  // is no statistics model or the model does not have the callee.
+  std::shared_ptr<const CalleeStatistics>
+  getCalleeStatistics(const std::string& funcName, size_t argCount);
 
   // Get the parameter name, if any, at the given zero-based index.
   std::optional<std::string> getParamName(const CallSite& site,
@@ -155,10 +304,88 @@ class Checker {
   }
 
   struct MorphemeSet {
-    std::set<std::string> Morphemes;
+    MorphemeIdSet Morphemes;
     // Position is zero-based.
     size_t Position;
   };
+  // The morpheme sets for a pair of arguments, referring into a SiteMorphemes
+  // table.
+  using MorphemeSetPair = std::pair<const MorphemeSet&, const MorphemeSet&>;
+
+  // The morphemes for the argument at one position of a call site.
+  struct ArgumentMorphemes {
+    MorphemeSet Arg;
+    // The signature of the argument's morphemes.
+    uint64_t Signature = 0;
+    // False if the argument has no usable morphemes.
+    bool Usable = false;
+  };
+
+  // How well an argument's morphemes match a parameter's morphemes, comparing
+  // their complete sets. Each bias is only matched the first time it is needed;
+  // until then, it is negative.
+  struct MorphemeMatch {
+    float Optimistic = -1.0f, Pessimistic = -1.0f;
+  };
+
+  struct SiteMorphemes {
+    std::vector<ArgumentMorphemes> Args;
+    // How well each argument matches each parameter, by argument then by
+    // parameter. Filled in by siteMatch() as the checks ask for them.
+    std::vector<MorphemeMatch> Matches;
+  };
+
+  // Splits the first argCount arguments at the call site into morphemes,
+  // filling in one entry of the table for each argument position. The table
+  // may be reused from an earlier call site, in which case its memory is
+  // reused as well.
+  void splitSite(const CallSite& site, size_t argCount, SiteMorphemes& table);
+
+  // The morphemes for the parameters of a callee's declaration, which are the
+  // same at every call site to that declaration.
+  struct DeclMorphemes {
+    struct Param {
+      // Empty if there is no named parameter at this position.
+      MorphemeIdSet Morphemes;
+      bool Named = false;
+      // False if the parameter is named but has no usable morphemes.
+      bool Usable = false;
+    };
+    // Indexed by zero-based position.
+    std::vector<Param> Params;
+    // The non-low entropy morphemes of each usable parameter which are not
+    // in another usable parameter, at index (pos * Params.size() + other).
+    std::vector<MorphemeIdSet> UniqueMorphemes;
+    // The signature of each set of unique morphemes, indexed the same way.
+    std::vector<uint64_t> UniqueSignatures;
+
+    // Returns the parameter at the given position, if there is one.
+    const Param* param(size_t pos) const {
+      return pos < Params.size() ? &Params[pos] : nullptr;
+    }
+    const MorphemeIdSet& uniqueMorphemes(size_t pos, size_t other) const {
+      return UniqueMorphemes[pos * Params.size() + other];
+    }
+    uint64_t uniqueSignature(size_t pos, size_t other) const {
+      return UniqueSignatures[pos * Params.size() + other];
+    }
+  };
+
+  // The split parameters of recently checked declarations, keyed by their
+  // fully qualified name and parameter names.
+  std::mutex DeclCacheLock;
+  std::unordered_map<std::string, std::shared_ptr<const DeclMorphemes>>
+      DeclCache;
+
+  // Splits the parameter names of the callee's declaration into morphemes,
+  // reusing the results for the same declaration from an earlier call site.
+  std::shared_ptr<const DeclMorphemes>
+  getDeclMorphemes(const CallDeclDescriptor& decl);
+
+  // Finds rotations of three or more arguments at the call site, based on the
+  // matches in the table. Returns false if the sink asked to stop.
+  bool checkForRotations(const DeclMorphemes& decl, SiteMorphemes& table,
+                         ResultSink sink);
 
   MorphemeSet morphemeSetDifference(const MorphemeSet& one,
                                     const MorphemeSet& two) const;
@@ -172,13 +399,15 @@ class Checker {
     return site.positionalArgNames[pos].back();
   }
 
+  // The parameters at both argument positions must be usable. The callee
+  // statistics are null if no statistics model is loaded.
   std::optional<Result>
-  checkForCoverBasedSwap(const std::pair<MorphemeSet, MorphemeSet>& params,
-                         const std::pair<MorphemeSet, MorphemeSet>& args,
-                         const CallSite& callSite);
+  checkForCoverBasedSwap(const DeclMorphemes& decl, SiteMorphemes& table,
+                         const MorphemeSetPair& args, const CallSite& callSite,
+                         const CalleeStatistics* calleeStats);
 
-  float anyAreSynonyms(const std::string& morpheme,
-                       const std::set<std::string>& potentialSynonyms) const;
+  float anyAreSynonyms(MorphemeInterner::Id morpheme,
+                       const MorphemeIdSet& potentialSynonyms) const;
 
   // Helper struct for comparing against the bias when matching morphemes.
   enum class Bias { Pessimistic, Optimistic };
@@ -195,39 +424,56 @@ class Checker {
     bool Less;
   };
 
-  std::set<std::string>
-  nonLowEntropyDifference(const std::set<std::string>& lhs,
-                          const std::set<std::string>& rhs) const;
+  MorphemeIdSet nonLowEntropyDifference(const MorphemeIdSet& lhs,
+                                        const MorphemeIdSet& rhs) const;
 
-  float morphemesMatch(const std::set<std::string>& arg,
-                       const std::set<std::string>& param, Bias bias) const;
+  float morphemesMatch(const MorphemeIdSet& arg, const MorphemeIdSet& param,
+                       Bias bias) const;
+
+  // Returns how well the usable argument at one position of the call site
+  // matches the usable parameter at another, matching their morphemes the
+  // first time the pair is asked for with the given bias. Only the pairs the
+  // checks actually reach are matched, which for most call sites is a small
+  // part of every argument against every parameter.
+  float siteMatch(const DeclMorphemes& decl, SiteMorphemes& table, size_t arg,
+                  size_t param, Bias bias);
+
+  // Wraps the interned morphemes up for reporting in a Result.
+  MorphemeList morphemeList(const MorphemeIdSet& morphemes) const;
 
   std::optional<Result>
-  checkForStatisticsBasedSwap(const std::pair<MorphemeSet, MorphemeSet>& params,
-                              const std::pair<MorphemeSet, MorphemeSet>& args,
-                              const CallSite& callSite);
+  checkForStatisticsBasedSwap(const MorphemeSetPair& args,
+                              const CalleeStatistics& calleeStats);
   // Determines the confidence of how much more common it is to see the given
   // morpheme at the given position compared to another position. Returns values
   // in the range 0.0f (for no confidence) to 1.0 (for highest confidence) if
   // the function exists. Returns nullopt if the function cannot be found or if
   // the morpheme cannot be located at either position.
-  std::optional<float> morphemeConfidenceAtPosition(const CallSite& callSite,
-                                                    const std::string& morph,
-                                                    size_t pos,
-                                                    size_t comparedToPos) const;
+  std::optional<float>
+  morphemeConfidenceAtPosition(const CalleeStatistics& calleeStats,
+                               MorphemeInterner::Id morph, size_t pos,
+                               size_t comparedToPos) const;
 
   // Determines how "similar" two morphemes are, including abbreviations and
   // synonyms. Returns a value between [0, 1).
-  float similarity(const std::string& morph1, const std::string& morph2) const;
+  float similarity(MorphemeInterner::Id morph1,
+                   MorphemeInterner::Id morph2) const;
+
+  // Calls fn(id, similarity) for each morpheme in the statistics model which
+  // has a nonzero similarity to the given morpheme. This must agree with
+  // similarity(); it exists so that fitness can be computed by probing for
+  // the similar morphemes rather than by scanning every morpheme in the model.
+  template <typename Fn>
+  void forEachSimilarMorpheme(MorphemeInterner::Id morph, Fn fn) const;
 
   // Determines the fitness of a potential swap of the given morpheme when
   // compared to the other morphemes used at that position in other function
   // calls. Returns a value between [0, 1).
-  float fit(const std::string& morph, const CallSite& site,
+  float fit(MorphemeInterner::Id morph, const CalleeStatistics& calleeStats,
             size_t argPos) const;
 
 public:
-  Checker() = default;
+  Checker() : Checker(CheckerConfiguration()) {}
   explicit Checker(const CheckerConfiguration& opts);
   ~Checker();
 
@@ -237,13 +483,55 @@ public:
     All,
   };
 
-  // Checks for all argument swap errors at a given call site.
+  // Checks for all argument swap errors at a given call site. This may be
+  // called concurrently from multiple threads using the same Checker.
   // @param site Details about the call site.
   // @return All of the dected swaps at the site.
   std::vector<Result> CheckSite(const CallSite& site,
                                 Check whichCheck = Check::All);
 
+  // Checks for argument swap errors at a given call site, handing each one to
+  // the sink as soon as it is found instead of collecting them. Swaps scoring
+  // below minScore are skipped without being handed to the sink. Checking
+  // stops as soon as the sink returns false, so a sink can stop after the
+  // first swap, for instance.
+  // @return The number of swaps handed to the sink.
+  size_t CheckSite(const CallSite& site, ResultSink sink,
+                   Check whichCheck = Check::All, float minScore = 0.0f);
+
+  // Checks each of the given call sites for argument swap errors, spreading
+  // the sites across up to the given number of threads. A thread count of zero
+  // uses one thread for each hardware thread. The results for each site are
+  // the same as from calling CheckSite() on it, and are returned in the same
+  // order as the sites.
+  std::vector<std::vector<Result>> CheckSites(const CallSite* sites,
+                                              size_t count,
+                                              unsigned threads = 0,
+                                              Check whichCheck = Check::All);
+  std::vector<std::vector<Result>>
+  CheckSites(const std::vector<CallSite>& sites, unsigned threads = 0,
+             Check whichCheck = Check::All) {
+    return CheckSites(sites.data(), sites.size(), threads, whichCheck);
+  }
+
+  // Returns false if the statistics model definitely has nothing for the
+  // named callee, which is always the case when there is no model. The
+  // statistics-based check can never find a swap at a call to such a callee.
+  // This is far cheaper than checking a call site, so a caller can use it to
+  // skip building one, but it may return true for callees not in the model.
+  bool mayHaveStatistics(std::string_view funcName) const;
+
   const CheckerConfiguration& Options() const { return Opts; }
+
+  // Returns the totals for all of the calls to CheckSite() so far.
+  CheckerCounters counters() const;
+
+private:
+  // Checks a single call site, using the given table as scratch space. This
+  // lets a thread checking many call sites reuse one table for all of them.
+  // Returns false if the sink asked to stop.
+  bool checkSite(const CallSite& site, Check whichCheck, SiteMorphemes& table,
+                 ResultSink sink);
 };
 
 namespace test {
@@ -255,6 +543,13 @@ namespace test {
 // responsibility to delete the file when no longer needed.
 using StatsDBRow = std::tuple<std::string, size_t, std::string, float>;
 std::string createStatsDB(std::initializer_list<StatsDBRow> rows);
+// Similar to createStatsDB(), but the database uses the normalized schema of
+// the production models, where the weights are stored with integer references
+// into a table of strings and exposed through a weights view.
+std::string createNormalizedStatsDB(std::initializer_list<StatsDBRow> rows);
+// Returns the number of distinct models currently loaded and shared by the
+// Checker instances in this process.
+size_t loadedModelCount();
 } // namespace test
 } // end namespace swapped_arg
 #endif // GT_SWAPPED_ARG_CHECKER_H
@@ -30,8 +30,9 @@ static std::optional<std::string> PyStrToStr(PyObject* pystr) {
   return std::string(result, size);
 }
 
-/// Converts a std::set of morphemes to a Python set.
-static PyOwnedObject MorphemeSetToPy(const std::set<std::string>& morphemes) {
+/// Converts a list of morphemes to a Python set.
+static PyOwnedObject
+MorphemeSetToPy(const swapped_arg::MorphemeList& morphemes) {
   PyOwnedObject result(PySet_New(nullptr));
   if (!result)
     return PyOwnedObject();
@@ -101,12 +102,13 @@ static PyObject* Checker_Check(CheckerObject* self, PyObject* args,
   const char* callee = nullptr;
   PyObject* arguments = nullptr;
   PyObject* paramNames = nullptr;
+  float minScore = 0.0f;
 
   static const char* kwlist[] = {"arguments", "callee", "parameters",
-                                 nullptr};
-  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|zO:check2",
+                                 "min_score", nullptr};
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|zOf:check2",
                                    const_cast<char**>(kwlist), &arguments,
-                                   &callee, &paramNames))
+                                   &callee, &paramNames, &minScore))
     return nullptr;
 
   // Create the call site from all of the arguments passed into this
@@ -165,11 +167,19 @@ static PyObject* Checker_Check(CheckerObject* self, PyObject* args,
   if (!resultList)
     return nullptr;
 
-  for (const auto& result : self->checker.CheckSite(site)) {
-    PyOwnedObject resultDict = ResultToPy(result);
-    if (PyList_Append(resultList.get(), resultDict.get()) < 0)
-      return nullptr;
-  }
+  // Convert each result as it is found, and stop checking if that fails.
+  bool failed = false;
+  self->checker.CheckSite(
+      site,
+      [&](const swapped_arg::Result& result) {
+        PyOwnedObject resultDict = ResultToPy(result);
+        failed = !resultDict ||
+                 PyList_Append(resultList.get(), resultDict.get()) < 0;
+        return !failed;
+      },
+      swapped_arg::Checker::Check::All, minScore);
+  if (failed)
+    return nullptr;
 
   return resultList.release();
 }
@@ -181,6 +191,7 @@ static PyMethodDef Checker_methods[] = {
      "passed.\n"
      ":param callee: The name of the function being called.\n"
      ":param parameters: The names for the formal parameters of the callee.\n"
+     ":param min_score: Swaps scoring below this are not reported.\n"
      ":returns: A list of dicts describing swaps (or an empty list if no "
      "swaps were found)."},
     {nullptr}};
@@ -37,3 +37,12 @@ def test_multi_results():
     assert results[1]['arg2'] == 4
     assert isinstance(results[1]['morphemes1'], set)
     assert isinstance(results[1]['morphemes2'], set)
+
+
+def test_min_score():
+    checker = swappedargs.Checker()
+    results = checker.check_call(callee='bar',
+                                 parameters=['hi', 'lo', 'foo', 'bar'],
+                                 arguments=['lo', 'hi', 'bar', 'foo'],
+                                 min_score=1000)
+    assert results == []
@@ -0,0 +1,87 @@
+//===- BinaryModel.hpp ------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_SWAPPED_ARG_BINARY_MODEL_H
+#define GT_SWAPPED_ARG_BINARY_MODEL_H
+
+#include <cstdint>
+#include <cstring>
+
+// Layout of the read-only binary statistics model. The file is designed to be
+// memory mapped and used in place, so every table is a flat array of fixed-size
+// records that is located by an offset stored in the header. All integers are
+// stored in the byte order of the machine which wrote the file; the header's
+// ByteOrderMark is used to reject files written with a different byte order.
+//
+// The file consists of, in order:
+//   Header
+//   uint32_t StringOffsets[StringCount + 1]
+//   char     StringData[]       (each string is followed by a NUL byte)
+//   Function Functions[FunctionCount]
+//   Position Positions[PositionCount]
+//   Entry    Entries[EntryCount]
+//
+// Strings (function names and morphemes) are sorted bytewise and are referred
+// to by their index, so comparing two string IDs is the same as comparing the
+// strings. Functions are sorted by name, the positions for a function are
+// sorted by argument index, and the entries for a position are sorted by
+// morpheme. Every lookup is therefore a binary search.
+namespace swapped_arg {
+namespace binary_model {
+constexpr char Magic[8] = {'S', 'W', 'P', 'M', 'O', 'D', 'E', 'L'};
+constexpr uint32_t CurrentVersion = 1;
+constexpr uint32_t ByteOrderMark = 0x01020304;
+
+struct Header {
+  char Magic[8];
+  uint32_t Version;
+  uint32_t ByteOrderMark;
+  uint32_t StringCount;
+  uint32_t FunctionCount;
+  uint32_t PositionCount;
+  uint32_t EntryCount;
+  uint64_t StringOffsetsOffset;
+  uint64_t StringDataOffset;
+  uint64_t StringDataSize;
+  uint64_t FunctionsOffset;
+  uint64_t PositionsOffset;
+  uint64_t EntriesOffset;
+};
+
+struct Function {
+  uint32_t Name;
+  uint32_t FirstPosition;
+  uint32_t PositionCount;
+};
+
+struct Position {
+  uint32_t Arg;
+  uint32_t FirstEntry;
+  uint32_t EntryCount;
+};
+
+struct Entry {
+  uint32_t Morpheme;
+  float Weight;
+};
+
+// Returns true if the given bytes are the start of a binary model file.
+inline bool hasMagic(const char* bytes, size_t size) {
+  return size >= sizeof(Magic) && std::memcmp(bytes, Magic, sizeof(Magic)) == 0;
+}
+} // end namespace binary_model
+} // end namespace swapped_arg
+
+#endif // GT_SWAPPED_ARG_BINARY_MODEL_H
@@ -16,26 +16,40 @@
 #include "IdentifierSplitting.hpp"
 #include <algorithm>
 #include <cctype>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 
-using namespace swapped_arg;
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GT_SWAPPED_ARG_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
-static std::string lower(const char* wordStart, const char* wordEnd) {
-  std::string str(wordStart, wordEnd);
-  // FIXME: use of tolower() depends on the current C locale.
-  std::transform(str.begin(), str.end(), str.begin(),
-                 [](unsigned char c) { return std::tolower(c); });
-  return str;
-}
+using namespace swapped_arg;
 
-std::set<std::string>
-IdentifierSplitter::split(const std::string& input) const {
+// Calls fn with each lowercased word in the identifier, in order. Words may be
+// repeated. This handles any identifier, but classifies and lowercases one
+// character at a time according to the current C locale.
+template <typename Fn>
+static void forEachWordScalar(const std::string& input, Fn fn) {
   // This is a rudimentary implementation that splits only on transition from
   // lowercase to uppercase, or when finding a hard word boundary like _.
   // This does not do anything special to handle double underscores, leading
   // or trailing underscores, etc. It's just a placeholder for testing.
   // FIXME: use of islower() and isupper() depends on the current C locale.
+  std::string word;
+  auto emit = [&word, &fn](const char* wordStart, const char* wordEnd) {
+    word.assign(wordStart, wordEnd);
+    // FIXME: use of tolower() depends on the current C locale.
+    std::transform(word.begin(), word.end(), word.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    fn(std::string_view(word));
+  };
 
-  std::set<std::string> ret;
   const char* wordStart = input.data();
   bool prevCharWasLower = std::islower(*wordStart);
   for (const char *curLoc = wordStart, *end = wordStart + input.length();
@@ -44,12 +58,12 @@ IdentifierSplitter::split(const std::string& input) const {
       // We've ended the word. Add only if we have an actual word, which
       // handles duplicate underscores.
       if (wordStart != curLoc) {
-        ret.insert(lower(wordStart, curLoc));
+        emit(wordStart, curLoc);
       }
       wordStart = curLoc + 1; // Advance past the _.
     } else if (std::isupper(*curLoc) && prevCharWasLower) {
       // Transitions from lowercase to uppercase are treated as a word boundary.
-      ret.insert(lower(wordStart, curLoc));
+      emit(wordStart, curLoc);
       wordStart = curLoc; // Start at the capital letter.
     }
     prevCharWasLower = std::islower(*curLoc);
@@ -57,8 +71,210 @@ IdentifierSplitter::split(const std::string& input) const {
 
   // Add the last part of the string, if any, to the splits.
   if (wordStart != input.data() + input.length()) {
-    ret.insert(lower(wordStart, input.data() + input.length()));
+    emit(wordStart, input.data() + input.length());
+  }
+}
+
+namespace {
+// How each ASCII character is classified for splitting, and what it is when
+// lowercased. These match the "C" locale, whatever the current locale is.
+struct AsciiTables {
+  enum : uint8_t { Lower = 1, Upper = 2, Underscore = 4 };
+  uint8_t Class[128];
+  char ToLower[128];
+
+  constexpr AsciiTables() : Class(), ToLower() {
+    for (int c = 0; c < 128; ++c) {
+      ToLower[c] = static_cast<char>(c);
+      if (c >= 'a' && c <= 'z') {
+        Class[c] = Lower;
+      } else if (c >= 'A' && c <= 'Z') {
+        Class[c] = Upper;
+        ToLower[c] = static_cast<char>(c - 'A' + 'a');
+      } else if (c == '_') {
+        Class[c] = Underscore;
+      }
+    }
+  }
+};
+constexpr AsciiTables Ascii;
+
+// The number of characters classified at once, which is the width of an SSE2
+// register.
+constexpr size_t ChunkSize = 16;
+
+// Bit masks of the characters in a chunk with each classification, where bit
+// N describes the Nth character of the chunk.
+struct ChunkClasses {
+  uint32_t Lower = 0, Upper = 0, Underscore = 0;
+};
+} // namespace
+
+static unsigned countTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanForward(&idx, value);
+  return idx;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+static bool isAscii(const char* data, size_t length) {
+  size_t pos = 0;
+#ifdef GT_SWAPPED_ARG_SSE2
+  __m128i bits = _mm_setzero_si128();
+  for (; pos + ChunkSize <= length; pos += ChunkSize)
+    bits = _mm_or_si128(
+        bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)));
+  if (_mm_movemask_epi8(bits))
+    return false;
+#endif
+  for (; pos < length; ++pos)
+    if (static_cast<unsigned char>(data[pos]) >= 128)
+      return false;
+  return true;
+}
+
+// Classifies count ASCII characters from src and writes them, lowercased, to
+// dest.
+static ChunkClasses classifyChunk(const char* src, size_t count, char* dest) {
+  ChunkClasses ret;
+#ifdef GT_SWAPPED_ARG_SSE2
+  if (count == ChunkSize) {
+    // Every character is ASCII, so the signed comparisons are safe.
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i lower =
+        _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('a' - 1)),
+                      _mm_cmplt_epi8(chars, _mm_set1_epi8('z' + 1)));
+    __m128i upper =
+        _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('A' - 1)),
+                      _mm_cmplt_epi8(chars, _mm_set1_epi8('Z' + 1)));
+    __m128i underscore = _mm_cmpeq_epi8(chars, _mm_set1_epi8('_'));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dest),
+        _mm_add_epi8(chars, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+    ret.Lower = _mm_movemask_epi8(lower);
+    ret.Upper = _mm_movemask_epi8(upper);
+    ret.Underscore = _mm_movemask_epi8(underscore);
+    return ret;
+  }
+#endif
+  for (size_t idx = 0; idx < count; ++idx) {
+    unsigned char c = src[idx];
+    uint8_t cls = Ascii.Class[c];
+    ret.Lower |= uint32_t((cls & AsciiTables::Lower) != 0) << idx;
+    ret.Upper |= uint32_t((cls & AsciiTables::Upper) != 0) << idx;
+    ret.Underscore |= uint32_t((cls & AsciiTables::Underscore) != 0) << idx;
+    dest[idx] = Ascii.ToLower[c];
+  }
+  return ret;
+}
+
+// Calls fn with each lowercased word in the identifier, in order, exactly as
+// forEachWordScalar() does. Rather than looking at one character at a time,
+// this finds the word boundaries in a whole chunk of characters at once.
+// Returns false without calling fn if the identifier is not entirely ASCII.
+template <typename Fn>
+static bool forEachWordAscii(const std::string& input, Fn fn) {
+  const char* data = input.data();
+  size_t length = input.length();
+  if (!isAscii(data, length))
+    return false;
+
+  // The words are handed out as views of the lowercased identifier, which is
+  // kept on the stack unless the identifier is unusually long.
+  char stackBuf[128];
+  std::unique_ptr<char[]> heapBuf;
+  char* lowered = stackBuf;
+  if (length > sizeof(stackBuf)) {
+    heapBuf.reset(new char[length]);
+    lowered = heapBuf.get();
   }
 
+  size_t wordStart = 0;
+  uint32_t prevCharWasLower = 0;
+  for (size_t chunk = 0; chunk < length; chunk += ChunkSize) {
+    size_t count = std::min(ChunkSize, length - chunk);
+    ChunkClasses classes = classifyChunk(data + chunk, count, lowered + chunk);
+
+    // Words end at underscores, and a new word starts at an uppercase letter
+    // which follows a lowercase one.
+    uint32_t boundaries =
+        classes.Underscore |
+        (classes.Upper & ((classes.Lower << 1) | prevCharWasLower));
+    prevCharWasLower = (classes.Lower >> (count - 1)) & 1;
+    for (; boundaries; boundaries &= boundaries - 1) {
+      unsigned bit = countTrailingZeros(boundaries);
+      size_t pos = chunk + bit;
+      if (pos != wordStart)
+        fn(std::string_view(lowered + wordStart, pos - wordStart));
+      // Skip past underscores, but start the next word at a capital letter.
+      wordStart = (classes.Underscore >> bit) & 1 ? pos + 1 : pos;
+    }
+  }
+
+  // Add the last part of the string, if any, to the splits.
+  if (wordStart != length)
+    fn(std::string_view(lowered + wordStart, length - wordStart));
+  return true;
+}
+
+// Calls fn with each lowercased word in the identifier, in order. Words may be
+// repeated.
+template <typename Fn>
+static void forEachWord(const std::string& input, Fn fn) {
+  if (!forEachWordAscii(input, fn))
+    forEachWordScalar(input, fn);
+}
+
+std::set<std::string>
+IdentifierSplitter::split(const std::string& input) const {
+  std::set<std::string> ret;
+  forEachWord(input, [&ret](std::string_view word) { ret.emplace(word); });
+  return ret;
+}
+
+MorphemeIdSet IdentifierSplitter::split(const std::string& input,
+                                        MorphemeInterner& interner) const {
+  if (MemoCapacity) {
+    std::shared_lock<std::shared_mutex> guard(MemoLock);
+    if (MemoInterner == &interner) {
+      auto iter = Memo.find(input);
+      if (iter != Memo.end()) {
+        ++MemoHits;
+        return iter->second;
+      }
+    }
+  }
+
+  MorphemeIdSet ret;
+  forEachWord(input, [&ret, &interner](std::string_view word) {
+    ret.insert(interner.intern(word));
+  });
+
+  if (MemoCapacity) {
+    ++MemoMisses;
+    std::unique_lock<std::shared_mutex> guard(MemoLock);
+    if (!MemoInterner)
+      MemoInterner = &interner;
+    if (MemoInterner == &interner) {
+      // Rather than tracking how recently each identifier was used, start over
+      // once the memo fills up.
+      if (Memo.size() >= MemoCapacity)
+        Memo.clear();
+      Memo.try_emplace(input, ret);
+    }
+  }
   return ret;
 }
+
+void test::forEachWordScalar(const std::string& input,
+                             const std::function<void(std::string_view)>& fn) {
+  ::forEachWordScalar(input, fn);
+}
+
+bool test::forEachWordAscii(const std::string& input,
+                            const std::function<void(std::string_view)>& fn) {
+  return ::forEachWordAscii(input, fn);
+}
@@ -0,0 +1,59 @@
+//===- MorphemeInterner.cpp -------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#include "MorphemeInterner.hpp"
+#include <cassert>
+#include <limits>
+#include <mutex>
+
+using namespace swapped_arg;
+
+MorphemeInterner::Id MorphemeInterner::intern(std::string_view morpheme) {
+  if (std::optional<Id> id = find(morpheme))
+    return *id;
+
+  std::unique_lock<std::shared_mutex> guard(Lock);
+  // Another thread may have interned the morpheme after the lookup above.
+  auto iter = Ids.find(morpheme);
+  if (iter != Ids.end())
+    return iter->second;
+
+  assert(Strings.size() < std::numeric_limits<Id>::max() &&
+         "too many morphemes to intern");
+  Id id = static_cast<Id>(Strings.size());
+  Strings.emplace_back(morpheme);
+  Ids.emplace(Strings.back(), id);
+  return id;
+}
+
+std::optional<MorphemeInterner::Id>
+MorphemeInterner::find(std::string_view morpheme) const {
+  std::shared_lock<std::shared_mutex> guard(Lock);
+  auto iter = Ids.find(morpheme);
+  if (iter == Ids.end())
+    return std::nullopt;
+  return iter->second;
+}
+
+const std::string& MorphemeInterner::str(Id id) const {
+  std::shared_lock<std::shared_mutex> guard(Lock);
+  assert(id < Strings.size() && "unknown morpheme identifier");
+  return Strings[id];
+}
+
+size_t MorphemeInterner::size() const {
+  std::shared_lock<std::shared_mutex> guard(Lock);
+  return Strings.size();
+}
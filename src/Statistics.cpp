@@ -0,0 +1,938 @@
+//===- Statistics.cpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#include "Statistics.hpp"
+#include "BinaryModel.hpp"
+#include "SwappedArgChecker.hpp"
+#include "sqlite3.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <sys/types.h>
+#else
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace swapped_arg;
+
+bool swapped_arg::isNormalizedSchema(sqlite3* db) {
+  sqlite3_stmt* query = nullptr;
+  if (SQLITE_OK !=
+      sqlite3_prepare_v2(db,
+                         "SELECT COUNT(*) FROM sqlite_master WHERE type == "
+                         "'table' AND name IN ('strings', 'weights_data')",
+                         -1, &query, nullptr))
+    return false;
+  bool ret = sqlite3_step(query) == SQLITE_ROW &&
+             sqlite3_column_int(query, 0) == 2;
+  (void)sqlite3_finalize(query);
+  return ret;
+}
+
+namespace {
+// Helper RAII structure which resets a query and its bindings on destruction.
+class QueryResetter {
+  sqlite3_stmt* query;
+
+public:
+  explicit QueryResetter(sqlite3_stmt* stmt) : query(stmt) {}
+  ~QueryResetter() {
+    (void)sqlite3_clear_bindings(query);
+    (void)sqlite3_reset(query);
+  }
+};
+
+// A read-only connection to a SQLite model along with its prepared queries.
+// A connection must only be used by one thread at a time. When the model uses
+// the normalized schema, the function name is resolved to its string ID once
+// and weights_data is queried by integer, bypassing the weights view.
+class SQLiteConnection {
+  sqlite3* db = nullptr;
+  sqlite3_stmt* callee_query = nullptr;
+  // These queries are only used with the normalized schema.
+  sqlite3_stmt* string_id_query = nullptr;
+  sqlite3_stmt* string_value_query = nullptr;
+  // Morphemes read from weights_data, by their string ID.
+  std::unordered_map<sqlite3_int64, std::string> Morphemes;
+  bool Normalized = false;
+
+  // Finds the string ID for the given string. Returns nullopt if the model
+  // does not contain the string.
+  std::optional<sqlite3_int64> stringId(const std::string& str) {
+    QueryResetter resetter(string_id_query);
+    (void)sqlite3_bind_text(string_id_query, 1, str.c_str(), -1,
+                            SQLITE_TRANSIENT);
+    if (sqlite3_step(string_id_query) != SQLITE_ROW)
+      return std::nullopt;
+    return sqlite3_column_int64(string_id_query, 0);
+  }
+
+  // Finds the morpheme with the given string ID. Returns nullptr if the model
+  // does not contain the string.
+  const std::string* morpheme(sqlite3_int64 id) {
+    auto iter = Morphemes.find(id);
+    if (iter != Morphemes.end())
+      return &iter->second;
+
+    QueryResetter resetter(string_value_query);
+    (void)sqlite3_bind_int64(string_value_query, 1, id);
+    if (sqlite3_step(string_value_query) != SQLITE_ROW)
+      return nullptr;
+    return &Morphemes
+                .try_emplace(id, reinterpret_cast<const char*>(
+                                     sqlite3_column_text(string_value_query, 0)))
+                .first->second;
+  }
+
+public:
+  explicit SQLiteConnection(const std::string& path) {
+    // The connection is only ever used by one thread at a time, so SQLite's
+    // per-connection mutex is unnecessary. Memory mapping the file lets the
+    // connections (and processes) opened on the same model share its pages
+    // rather than each holding a private copy in their page caches.
+    if (path.empty() ||
+        SQLITE_OK != sqlite3_open_v2(path.c_str(), &db,
+                                     SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+                                     nullptr))
+      return;
+    (void)sqlite3_exec(db, "PRAGMA mmap_size = 268435456", nullptr, nullptr,
+                       nullptr);
+
+    Normalized = isNormalizedSchema(db);
+    if (Normalized) {
+      (void)sqlite3_prepare_v2(
+          db, "SELECT arg, morpheme, value FROM weights_data WHERE func == ?",
+          -1, &callee_query, nullptr);
+      (void)sqlite3_prepare_v2(db,
+                               "SELECT rowid FROM strings WHERE value == ?", -1,
+                               &string_id_query, nullptr);
+      (void)sqlite3_prepare_v2(db,
+                               "SELECT value FROM strings WHERE rowid == ?", -1,
+                               &string_value_query, nullptr);
+    } else {
+      (void)sqlite3_prepare_v2(
+          db, "SELECT arg, morpheme, value FROM weights WHERE func == ?", -1,
+          &callee_query, nullptr);
+    }
+  }
+  ~SQLiteConnection() {
+    for (sqlite3_stmt* query :
+         {callee_query, string_id_query, string_value_query}) {
+      if (query) {
+        (void)sqlite3_finalize(query);
+      }
+    }
+    if (db) {
+      (void)sqlite3_close(db);
+    }
+  }
+  SQLiteConnection(const SQLiteConnection&) = delete;
+  SQLiteConnection& operator=(const SQLiteConnection&) = delete;
+
+  bool valid() const {
+    return db != nullptr && callee_query != nullptr &&
+           (!Normalized ||
+            (string_id_query != nullptr && string_value_query != nullptr));
+  }
+
+  // Reads the name of every function in the model. Returns nullopt if the
+  // names could not be read.
+  std::optional<std::vector<std::string>> functionNames() {
+    sqlite3_stmt* query = nullptr;
+    if (SQLITE_OK !=
+        sqlite3_prepare_v2(db,
+                           Normalized ? "SELECT value FROM strings WHERE rowid "
+                                        "IN (SELECT func FROM weights_data)"
+                                      : "SELECT DISTINCT func FROM weights",
+                           -1, &query, nullptr))
+      return std::nullopt;
+
+    std::optional<std::vector<std::string>> ret(std::in_place);
+    for (;;) {
+      int rc = sqlite3_step(query);
+      if (rc == SQLITE_DONE)
+        break;
+      if (rc != SQLITE_ROW) {
+        ret.reset();
+        break;
+      }
+      ret->emplace_back(
+          reinterpret_cast<const char*>(sqlite3_column_text(query, 0)));
+    }
+    (void)sqlite3_finalize(query);
+    return ret;
+  }
+
+  CalleeStatistics weightsForCallee(const std::string& funcName,
+                                    const std::vector<size_t>& argPositions,
+                                    MorphemeInterner& morphemes) {
+    assert(valid() && "no valid database loaded");
+
+    QueryResetter resetter(callee_query);
+    if (Normalized) {
+      std::optional<sqlite3_int64> funcId = stringId(funcName);
+      if (!funcId)
+        return CalleeStatistics();
+      (void)sqlite3_bind_int64(callee_query, 1, *funcId);
+    } else {
+      (void)sqlite3_bind_text(callee_query, 1, funcName.c_str(), -1,
+                              SQLITE_TRANSIENT);
+    }
+
+    CalleeStatistics ret;
+    for (;;) {
+      int rc = sqlite3_step(callee_query);
+      if (rc == SQLITE_DONE) {
+        break;
+      } else if (rc == SQLITE_ROW) {
+        sqlite3_int64 arg = sqlite3_column_int64(callee_query, 0);
+        if (arg < 0 || std::find(argPositions.begin(), argPositions.end(),
+                                 static_cast<size_t>(arg)) ==
+                           argPositions.end())
+          continue;
+
+        std::string_view morph;
+        if (Normalized) {
+          const std::string* m =
+              morpheme(sqlite3_column_int64(callee_query, 1));
+          if (!m)
+            continue;
+          morph = *m;
+        } else {
+          morph = reinterpret_cast<const char*>(
+              sqlite3_column_text(callee_query, 1));
+        }
+        ret.add(static_cast<size_t>(arg), morphemes.intern(morph),
+                static_cast<float>(sqlite3_column_double(callee_query, 2)));
+      } else {
+        return CalleeStatistics();
+      }
+    }
+    return ret;
+  }
+};
+
+// Statistics which are queried directly from the SQLite model. Each thread
+// doing a lookup checks a connection out of a pool for the duration of the
+// lookup, so concurrent lookups never share a connection or prepared query.
+// The pool grows to the number of threads doing lookups at the same time.
+class SQLiteStatistics : public Statistics {
+  std::string Path;
+  bool Opened = false;
+  mutable std::mutex PoolLock;
+  mutable std::vector<std::unique_ptr<SQLiteConnection>> Idle;
+
+  // Helper RAII structure which checks a connection out of the pool on
+  // construction and returns it to the pool on destruction.
+  class Lease {
+    const SQLiteStatistics& Stats;
+    std::unique_ptr<SQLiteConnection> Conn;
+
+  public:
+    explicit Lease(const SQLiteStatistics& stats) : Stats(stats) {
+      {
+        std::lock_guard<std::mutex> guard(Stats.PoolLock);
+        if (!Stats.Idle.empty()) {
+          Conn = std::move(Stats.Idle.back());
+          Stats.Idle.pop_back();
+        }
+      }
+      // Open the new connection outside of the lock so other threads are not
+      // held up by it.
+      if (!Conn)
+        Conn = std::make_unique<SQLiteConnection>(Stats.Path);
+    }
+    ~Lease() {
+      if (!Conn->valid())
+        return;
+      std::lock_guard<std::mutex> guard(Stats.PoolLock);
+      Stats.Idle.push_back(std::move(Conn));
+    }
+
+    SQLiteConnection* operator->() const { return Conn.get(); }
+  };
+
+public:
+  explicit SQLiteStatistics(const std::string& path) : Path(path) {
+    // We purposefully do not care about a failure to load the database at this
+    // stage. The valid() method can be used to determine if the Statistics
+    // object is valid or not. The first connection is kept for later use.
+    auto conn = std::make_unique<SQLiteConnection>(Path);
+    Opened = conn->valid();
+    if (!Opened)
+      return;
+    // If the function names cannot be read, every function is assumed to be
+    // in the model and is looked up.
+    if (std::optional<std::vector<std::string>> names = conn->functionNames())
+      setFunctionNames(*names);
+    Idle.push_back(std::move(conn));
+  }
+
+  bool valid() const override { return Opened; }
+
+  CalleeStatistics
+  weightsForCallee(const std::string& funcName,
+                   const std::vector<size_t>& argPositions,
+                   MorphemeInterner& morphemes) const override {
+    Lease conn(*this);
+    if (!conn->valid())
+      return CalleeStatistics();
+    return conn->weightsForCallee(funcName, argPositions, morphemes);
+  }
+};
+
+// Statistics which are read out of the SQLite model once, when the model is
+// opened, and are then answered from a hash table keyed on interned function
+// identifiers and positions. No SQLite calls are made after construction.
+class InMemoryStatistics : public Statistics {
+  // Function names and morphemes share a single pool of interned strings.
+  std::unordered_map<std::string, uint32_t> StringIds;
+  std::vector<std::string> Strings;
+
+  // All of the (morpheme, weight) rows for a (function, position) pair, keyed
+  // by the function identifier in the upper 32 bits and the position in the
+  // lower 32 bits.
+  std::unordered_map<uint64_t, std::vector<std::pair<uint32_t, float>>>
+      Positions;
+
+  bool Loaded = false;
+
+  uint32_t intern(const char* str) {
+    auto [iter, inserted] =
+        StringIds.try_emplace(str, static_cast<uint32_t>(Strings.size()));
+    if (inserted)
+      Strings.push_back(iter->first);
+    return iter->second;
+  }
+
+  std::optional<uint32_t> lookup(const std::string& str) const {
+    auto iter = StringIds.find(str);
+    if (iter == StringIds.end())
+      return std::nullopt;
+    return iter->second;
+  }
+
+  static uint64_t positionKey(uint32_t func, uint32_t arg) {
+    return (static_cast<uint64_t>(func) << 32) | arg;
+  }
+
+  static std::optional<uint32_t> narrowPosition(size_t argPos) {
+    if (argPos > std::numeric_limits<uint32_t>::max())
+      return std::nullopt;
+    return static_cast<uint32_t>(argPos);
+  }
+
+public:
+  explicit InMemoryStatistics(const std::string& path) {
+    sqlite3* db = nullptr;
+    if (path.empty() ||
+        SQLITE_OK !=
+            sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr)) {
+      (void)sqlite3_close(db);
+      return;
+    }
+
+    sqlite3_stmt* query = nullptr;
+    if (SQLITE_OK == sqlite3_prepare_v2(
+                         db, "SELECT func, arg, morpheme, value FROM weights",
+                         -1, &query, nullptr)) {
+      for (;;) {
+        int rc = sqlite3_step(query);
+        if (rc == SQLITE_DONE) {
+          Loaded = true;
+          break;
+        } else if (rc != SQLITE_ROW) {
+          break;
+        }
+
+        sqlite3_int64 arg = sqlite3_column_int64(query, 1);
+        if (arg < 0 || arg > std::numeric_limits<uint32_t>::max())
+          continue;
+        uint32_t func = intern(
+            reinterpret_cast<const char*>(sqlite3_column_text(query, 0)));
+        uint32_t morpheme = intern(
+            reinterpret_cast<const char*>(sqlite3_column_text(query, 2)));
+        float value = static_cast<float>(sqlite3_column_double(query, 3));
+
+        Positions[positionKey(func, static_cast<uint32_t>(arg))].emplace_back(
+            morpheme, value);
+      }
+      (void)sqlite3_finalize(query);
+    }
+    (void)sqlite3_close(db);
+
+    std::vector<uint32_t> funcs;
+    funcs.reserve(Positions.size());
+    for (const auto& entry : Positions)
+      funcs.push_back(static_cast<uint32_t>(entry.first >> 32));
+    std::sort(funcs.begin(), funcs.end());
+    funcs.erase(std::unique(funcs.begin(), funcs.end()), funcs.end());
+    std::vector<std::string_view> names;
+    names.reserve(funcs.size());
+    for (uint32_t func : funcs)
+      names.push_back(Strings[func]);
+    setFunctionNames(names);
+  }
+
+  bool valid() const override { return Loaded; }
+
+  CalleeStatistics
+  weightsForCallee(const std::string& funcName,
+                   const std::vector<size_t>& argPositions,
+                   MorphemeInterner& morphemes) const override {
+    assert(valid() && "no valid database loaded");
+    CalleeStatistics ret;
+    std::optional<uint32_t> func = lookup(funcName);
+    if (!func)
+      return ret;
+
+    for (size_t argPos : argPositions) {
+      std::optional<uint32_t> arg = narrowPosition(argPos);
+      if (!arg)
+        continue;
+      auto iter = Positions.find(positionKey(*func, *arg));
+      if (iter == Positions.end())
+        continue;
+      for (const auto& [morpheme, value] : iter->second)
+        ret.add(argPos, morphemes.intern(Strings[morpheme]), value);
+    }
+    return ret;
+  }
+};
+
+// A read-only view of an entire file, which is memory mapped so that the
+// operating system can share the pages between processes using the same file.
+class MappedFile {
+  const char* Data = nullptr;
+  size_t Size = 0;
+#ifdef _WIN32
+  HANDLE Mapping = nullptr;
+#endif
+
+public:
+  explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      return;
+    LARGE_INTEGER size;
+    if (::GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+      Mapping =
+          ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (Mapping) {
+        Data = static_cast<const char*>(
+            ::MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0));
+        if (Data)
+          Size = static_cast<size_t>(size.QuadPart);
+      }
+    }
+    ::CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* addr = ::mmap(nullptr, static_cast<size_t>(info.st_size),
+                          PROT_READ, MAP_SHARED, fd, 0);
+      if (addr != MAP_FAILED) {
+        Data = static_cast<const char*>(addr);
+        Size = static_cast<size_t>(info.st_size);
+      }
+    }
+    // The mapping remains valid after the descriptor is closed.
+    ::close(fd);
+#endif
+  }
+  ~MappedFile() {
+#ifdef _WIN32
+    if (Data)
+      ::UnmapViewOfFile(Data);
+    if (Mapping)
+      ::CloseHandle(Mapping);
+#else
+    if (Data)
+      ::munmap(const_cast<char*>(Data), Size);
+#endif
+  }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return Data; }
+  size_t size() const { return Size; }
+};
+
+// Statistics which are answered directly out of a memory-mapped binary model
+// file. See BinaryModel.hpp for a description of the file layout.
+class BinaryStatistics : public Statistics {
+  MappedFile File;
+  const binary_model::Header* Header = nullptr;
+  const uint32_t* StringOffsets = nullptr;
+  const char* StringData = nullptr;
+  const binary_model::Function* Functions = nullptr;
+  const binary_model::Position* Positions = nullptr;
+  const binary_model::Entry* Entries = nullptr;
+
+  // Returns a pointer to the table of count records starting at offset, or
+  // nullptr if the table does not fit within the file or is misaligned.
+  template <typename Ty>
+  const Ty* table(uint64_t offset, uint64_t count) const {
+    if (offset % alignof(Ty) != 0 || offset > File.size() ||
+        count > (File.size() - offset) / sizeof(Ty))
+      return nullptr;
+    return reinterpret_cast<const Ty*>(File.data() + offset);
+  }
+
+  std::string_view string(uint32_t id) const {
+    uint32_t begin = StringOffsets[id], end = StringOffsets[id + 1];
+    // The end offset includes the string's trailing NUL byte.
+    if (begin >= end || end > Header->StringDataSize)
+      return {};
+    return std::string_view(StringData + begin, end - begin - 1);
+  }
+
+  std::optional<uint32_t> findString(std::string_view str) const {
+    uint32_t low = 0, high = Header->StringCount;
+    while (low < high) {
+      uint32_t mid = low + (high - low) / 2;
+      int cmp = string(mid).compare(str);
+      if (cmp == 0)
+        return mid;
+      if (cmp < 0)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+    return std::nullopt;
+  }
+
+  // Finds the records for the given function, if the model has any.
+  const binary_model::Function* findFunction(const std::string& funcName) const {
+    std::optional<uint32_t> name = findString(funcName);
+    if (!name)
+      return nullptr;
+
+    const binary_model::Function *funcsEnd = Functions + Header->FunctionCount,
+                                 *func = std::lower_bound(
+                                     Functions, funcsEnd, *name,
+                                     [](const binary_model::Function& f,
+                                        uint32_t n) { return f.Name < n; });
+    if (func == funcsEnd || func->Name != *name ||
+        func->FirstPosition > Header->PositionCount ||
+        func->PositionCount > Header->PositionCount - func->FirstPosition)
+      return nullptr;
+    return func;
+  }
+
+  // Finds the records for the given argument position of a function, if the
+  // model has any.
+  const binary_model::Position*
+  findPosition(const binary_model::Function& func, size_t argPos) const {
+    const binary_model::Position *posBegin = Positions + func.FirstPosition,
+                                 *posEnd = posBegin + func.PositionCount,
+                                 *pos = std::lower_bound(
+                                     posBegin, posEnd, argPos,
+                                     [](const binary_model::Position& p,
+                                        size_t arg) { return p.Arg < arg; });
+    if (pos == posEnd || pos->Arg != argPos ||
+        pos->FirstEntry > Header->EntryCount ||
+        pos->EntryCount > Header->EntryCount - pos->FirstEntry)
+      return nullptr;
+    return pos;
+  }
+
+public:
+  explicit BinaryStatistics(const std::string& path) : File(path) {
+    if (!binary_model::hasMagic(File.data(), File.size()) ||
+        File.size() < sizeof(binary_model::Header))
+      return;
+    const auto* header =
+        reinterpret_cast<const binary_model::Header*>(File.data());
+    if (header->Version != binary_model::CurrentVersion ||
+        header->ByteOrderMark != binary_model::ByteOrderMark ||
+        header->StringCount == std::numeric_limits<uint32_t>::max())
+      return;
+
+    StringOffsets = table<uint32_t>(header->StringOffsetsOffset,
+                                    uint64_t{header->StringCount} + 1);
+    StringData = table<char>(header->StringDataOffset, header->StringDataSize);
+    Functions = table<binary_model::Function>(header->FunctionsOffset,
+                                              header->FunctionCount);
+    Positions = table<binary_model::Position>(header->PositionsOffset,
+                                              header->PositionCount);
+    Entries =
+        table<binary_model::Entry>(header->EntriesOffset, header->EntryCount);
+    if (!StringOffsets || !StringData || !Functions || !Positions || !Entries)
+      return;
+    Header = header;
+
+    std::vector<std::string_view> names;
+    names.reserve(Header->FunctionCount);
+    for (const binary_model::Function *func = Functions,
+                                      *end = Functions + Header->FunctionCount;
+         func != end; ++func) {
+      if (func->Name < Header->StringCount)
+        names.push_back(string(func->Name));
+    }
+    setFunctionNames(names);
+  }
+
+  bool valid() const override { return Header != nullptr; }
+
+  CalleeStatistics
+  weightsForCallee(const std::string& funcName,
+                   const std::vector<size_t>& argPositions,
+                   MorphemeInterner& morphemes) const override {
+    assert(valid() && "no valid database loaded");
+    CalleeStatistics ret;
+    const binary_model::Function* func = findFunction(funcName);
+    if (!func)
+      return ret;
+
+    for (size_t argPos : argPositions) {
+      const binary_model::Position* pos = findPosition(*func, argPos);
+      if (!pos)
+        continue;
+      for (const binary_model::Entry *entry = Entries + pos->FirstEntry,
+                                     *end = entry + pos->EntryCount;
+           entry != end; ++entry) {
+        if (entry->Morpheme < Header->StringCount)
+          ret.add(argPos, morphemes.intern(string(entry->Morpheme)),
+                  entry->Weight);
+      }
+    }
+    return ret;
+  }
+};
+
+// Determines whether the file at the given path is a binary model by looking
+// at its header.
+static bool isBinaryModel(const std::string& path) {
+  char magic[sizeof(binary_model::Magic)];
+  std::ifstream file(path, std::ios::binary);
+  if (!file.read(magic, sizeof(magic)))
+    return false;
+  return binary_model::hasMagic(magic, sizeof(magic));
+}
+
+// Identifies a loaded model in the process-wide model cache. The file's size
+// and modification time are part of the key so that a model which is replaced
+// on disk is loaded afresh rather than served stale from the cache.
+struct ModelKey {
+  std::string CanonicalPath;
+  long long ModificationTime = 0;
+  long long Size = 0;
+  bool InMemory = false;
+
+  bool operator<(const ModelKey& other) const {
+    return std::tie(CanonicalPath, ModificationTime, Size, InMemory) <
+           std::tie(other.CanonicalPath, other.ModificationTime, other.Size,
+                    other.InMemory);
+  }
+};
+
+// Computes the cache key for the model at the given path. Returns false if the
+// file cannot be found.
+static bool getModelKey(const std::string& path, bool inMemory,
+                        ModelKey& key) {
+#ifdef _WIN32
+  char resolved[_MAX_PATH];
+  if (!_fullpath(resolved, path.c_str(), sizeof(resolved)))
+    return false;
+  struct _stat64 info;
+  if (_stat64(resolved, &info) != 0)
+    return false;
+#else
+  char resolved[PATH_MAX];
+  if (!realpath(path.c_str(), resolved))
+    return false;
+  struct stat info;
+  if (stat(resolved, &info) != 0)
+    return false;
+#endif
+  key.CanonicalPath = resolved;
+  key.ModificationTime = static_cast<long long>(info.st_mtime);
+  key.Size = static_cast<long long>(info.st_size);
+  key.InMemory = inMemory;
+  return true;
+}
+
+// Every model opened by the process, keyed by the file it was loaded from.
+// Models are immutable once loaded, so Checkers configured with the same model
+// share a single instance; the cache only holds weak references so a model is
+// unloaded once the last Checker using it goes away.
+class ModelCache {
+  std::mutex Lock;
+  std::map<ModelKey, std::weak_ptr<const Statistics>> Models;
+
+public:
+  static ModelCache& instance() {
+    static ModelCache Cache;
+    return Cache;
+  }
+
+  // Returns the model for the given key, calling load() to create it if no
+  // live instance is cached. The lock is held while loading so that
+  // concurrent requests for the same model only load it once.
+  template <typename LoadFn>
+  std::shared_ptr<const Statistics> get(const ModelKey& key, LoadFn load) {
+    std::lock_guard<std::mutex> guard(Lock);
+    if (auto iter = Models.find(key); iter != Models.end()) {
+      if (std::shared_ptr<const Statistics> stats = iter->second.lock())
+        return stats;
+    }
+
+    // Drop the entries for models that have since been unloaded.
+    for (auto iter = Models.begin(); iter != Models.end();) {
+      if (iter->second.expired())
+        iter = Models.erase(iter);
+      else
+        ++iter;
+    }
+
+    std::shared_ptr<const Statistics> stats = load();
+    if (stats)
+      Models[key] = stats;
+    return stats;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> guard(Lock);
+    return std::count_if(Models.begin(), Models.end(), [](const auto& entry) {
+      return !entry.second.expired();
+    });
+  }
+};
+} // namespace
+
+FunctionFilter::FunctionFilter(size_t expectedCount) {
+  size_t words = 1;
+  while (words * 64 < expectedCount * BitsPerName)
+    words *= 2;
+  Bits.resize(words);
+}
+
+// Computes the two hashes that the filter's bit indexes are derived from. This
+// is 64-bit FNV-1a, with the second hash taken from a mix of the first.
+static std::pair<uint64_t, uint64_t> filterHashes(std::string_view name) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : name) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  uint64_t mixed = (hash ^ (hash >> 31)) * 0x9e3779b97f4a7c15ull;
+  // The step must be odd so that successive indexes do not repeat.
+  return {hash, (mixed ^ (mixed >> 29)) | 1};
+}
+
+void FunctionFilter::add(std::string_view name) {
+  assert(!Bits.empty() && "adding to a filter with no storage");
+  auto [index, step] = filterHashes(name);
+  uint64_t mask = Bits.size() * 64 - 1;
+  for (unsigned i = 0; i < HashCount; ++i, index += step)
+    Bits[(index & mask) / 64] |= uint64_t{1} << (index % 64);
+}
+
+bool FunctionFilter::mayContain(std::string_view name) const {
+  if (Bits.empty())
+    return true;
+  auto [index, step] = filterHashes(name);
+  uint64_t mask = Bits.size() * 64 - 1;
+  for (unsigned i = 0; i < HashCount; ++i, index += step) {
+    if (!(Bits[(index & mask) / 64] & (uint64_t{1} << (index % 64))))
+      return false;
+  }
+  return true;
+}
+
+void CalleeStatistics::add(size_t argPos, MorphemeId morpheme, float weight) {
+  auto iter = std::find_if(Positions.begin(), Positions.end(),
+                           [argPos](const auto& pos) {
+                             return pos.first == argPos;
+                           });
+  if (iter == Positions.end())
+    iter = Positions.emplace(Positions.end(), argPos, Distribution());
+  iter->second.try_emplace(morpheme, weight);
+}
+
+const CalleeStatistics::Distribution*
+CalleeStatistics::distributionAtPos(size_t argPos) const {
+  for (const auto& [pos, distribution] : Positions) {
+    if (pos == argPos)
+      return &distribution;
+  }
+  return nullptr;
+}
+
+std::optional<float>
+CalleeStatistics::weightForMorphemeAtPos(size_t argPos,
+                                         MorphemeId morph) const {
+  const Distribution* weights = distributionAtPos(argPos);
+  if (!weights)
+    return std::nullopt;
+  auto iter = weights->find(morph);
+  if (iter == weights->end())
+    return std::nullopt;
+  return iter->second;
+}
+
+std::unique_ptr<Statistics>
+Statistics::load(const CheckerConfiguration& opts) {
+  if (opts.ModelPath.empty())
+    return nullptr;
+
+  // Binary models are always memory mapped because they are already in a form
+  // that can be used directly; SQLite models can be queried in place or read
+  // into memory up front.
+  std::unique_ptr<Statistics> stats;
+  if (isBinaryModel(opts.ModelPath))
+    stats = std::make_unique<BinaryStatistics>(opts.ModelPath);
+  else if (opts.LoadModelInMemory)
+    stats = std::make_unique<InMemoryStatistics>(opts.ModelPath);
+  else
+    stats = std::make_unique<SQLiteStatistics>(opts.ModelPath);
+
+  // If we couldn't load valid stats, pretend there were no stats loaded at all
+  // rather than leave an invalid database around.
+  if (!stats->valid())
+    return nullptr;
+  return stats;
+}
+
+std::shared_ptr<const Statistics>
+Statistics::open(const CheckerConfiguration& opts) {
+  if (opts.ModelPath.empty())
+    return nullptr;
+
+  // Binary models are loaded the same way regardless of LoadModelInMemory, so
+  // don't let that setting split them into separate cache entries.
+  ModelKey key;
+  if (!getModelKey(opts.ModelPath,
+                   opts.LoadModelInMemory && !isBinaryModel(opts.ModelPath),
+                   key))
+    return nullptr;
+  return ModelCache::instance().get(
+      key, [&opts]() -> std::shared_ptr<const Statistics> {
+        return load(opts);
+      });
+}
+
+size_t test::loadedModelCount() { return ModelCache::instance().size(); }
+
+std::string test::createStatsDB(std::initializer_list<test::StatsDBRow> rows) {
+  std::string file_name = ::tmpnam(nullptr);
+
+  sqlite3* db = nullptr;
+  int rc = sqlite3_open(file_name.c_str(), &db);
+  if (rc != SQLITE_OK)
+    return "";
+
+  rc = sqlite3_exec(db,
+                    "CREATE TABLE weights ("
+                    "func TEXT NOT NULL,"
+                    "arg INTEGER NOT NULL CHECK(arg >= 0),"
+                    "morpheme TEXT NOT NULL,"
+                    "value REAL NOT NULL CHECK(value >= 0 AND value <= 1)"
+                    ");",
+                    nullptr, nullptr, nullptr);
+  assert(rc == SQLITE_OK && "Could not create a table in the database");
+
+  for (const auto& row : rows) {
+    auto [func, arg, morpheme, value] = row;
+    std::stringstream ss;
+    ss << "INSERT INTO weights "
+       << "('func', 'arg', 'morpheme', 'value')"
+       << "VALUES ('" << func << "', '" << arg << "', '" << morpheme << "', '"
+       << value << "');";
+    rc = sqlite3_exec(db, ss.str().c_str(), nullptr, nullptr, nullptr);
+    assert(rc == SQLITE_OK && "Could not add a row to the database");
+  }
+
+  (void)sqlite3_close(db);
+
+  return file_name;
+}
+
+std::string
+test::createNormalizedStatsDB(std::initializer_list<test::StatsDBRow> rows) {
+  std::string file_name = ::tmpnam(nullptr);
+
+  sqlite3* db = nullptr;
+  int rc = sqlite3_open(file_name.c_str(), &db);
+  if (rc != SQLITE_OK)
+    return "";
+
+  rc = sqlite3_exec(db,
+                    "CREATE TABLE strings ("
+                    "rowid INTEGER PRIMARY KEY AUTOINCREMENT,"
+                    "value TEXT UNIQUE NOT NULL"
+                    ");"
+                    "CREATE TABLE weights_data ("
+                    "func INTEGER NOT NULL,"
+                    "arg INTEGER NOT NULL CHECK(arg >= 0),"
+                    "morpheme INTEGER NOT NULL,"
+                    "value REAL NOT NULL CHECK(value >= 0 AND value <= 1),"
+                    "FOREIGN KEY(func) REFERENCES strings(rowid),"
+                    "FOREIGN KEY(morpheme) REFERENCES strings(rowid)"
+                    ");"
+                    "CREATE VIEW weights AS SELECT "
+                    "s_func.value AS func, arg, s_morpheme.value AS morpheme, "
+                    "weights_data.value AS value FROM weights_data "
+                    "INNER JOIN strings s_func ON s_func.rowid == func "
+                    "INNER JOIN strings s_morpheme "
+                    "ON s_morpheme.rowid == morpheme;",
+                    nullptr, nullptr, nullptr);
+  assert(rc == SQLITE_OK && "Could not create the tables in the database");
+
+  for (const auto& row : rows) {
+    auto [func, arg, morpheme, value] = row;
+    std::stringstream ss;
+    ss << "INSERT OR IGNORE INTO strings ('value') VALUES ('" << func
+       << "'), ('" << morpheme << "');"
+       << "INSERT INTO weights_data ('func', 'arg', 'morpheme', 'value') "
+       << "SELECT f.rowid, '" << arg << "', m.rowid, '" << value << "' "
+       << "FROM strings f, strings m WHERE f.value == '" << func
+       << "' AND m.value == '" << morpheme << "';";
+    rc = sqlite3_exec(db, ss.str().c_str(), nullptr, nullptr, nullptr);
+    assert(rc == SQLITE_OK && "Could not add a row to the database");
+  }
+
+  (void)sqlite3_close(db);
+
+  return file_name;
+}
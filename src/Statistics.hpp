@@ -0,0 +1,155 @@
+//===- Statistics.hpp -------------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#ifndef GT_SWAPPED_ARG_STATISTICS_H
+#define GT_SWAPPED_ARG_STATISTICS_H
+
+#include "MorphemeInterner.hpp"
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct sqlite3;
+
+namespace swapped_arg {
+struct CheckerConfiguration;
+
+// Returns true if the database uses the normalized model schema, where the
+// weights are stored in weights_data with integer references into strings and
+// the weights view joins the two tables back together.
+bool isNormalizedSchema(sqlite3* db);
+
+// A Bloom filter over the names of the functions in a model, used to cheaply
+// rule out callees the model knows nothing about before querying it. A
+// default-constructed filter has no data and may contain any name.
+class FunctionFilter {
+public:
+  FunctionFilter() = default;
+  // Creates an empty filter sized for the given number of names.
+  explicit FunctionFilter(size_t expectedCount);
+
+  void add(std::string_view name);
+
+  // Returns false if the name was definitely never added to the filter. A
+  // true result may be a false positive.
+  bool mayContain(std::string_view name) const;
+
+private:
+  // The number of bits set for each name; with ten bits per name, this gives
+  // a false positive rate below one percent.
+  static constexpr unsigned HashCount = 7;
+  static constexpr size_t BitsPerName = 10;
+
+  // The number of bits is a power of two so that indexes can be masked.
+  std::vector<uint64_t> Bits;
+};
+
+// A snapshot of the statistics for a single callee, restricted to the argument
+// positions that were requested when the snapshot was fetched. Checking a call
+// site reads from one of these rather than querying the model repeatedly.
+// Morphemes are identified by the interner used to fetch the snapshot.
+class CalleeStatistics {
+public:
+  using MorphemeId = MorphemeInterner::Id;
+  // The weight of each morpheme used at a position.
+  using Distribution = std::unordered_map<MorphemeId, float>;
+
+  // Adds a morpheme's weight at the given position. If a morpheme is added
+  // more than once at a position, the first weight wins.
+  void add(size_t argPos, MorphemeId morpheme, float weight);
+
+  // Returns true if the callee has no statistics at any requested position.
+  bool empty() const { return Positions.empty(); }
+
+  // Finds how often the given morpheme is used at the specified position.
+  // Returns nullopt if there is no data for the morpheme at that position.
+  std::optional<float> weightForMorphemeAtPos(size_t argPos,
+                                              MorphemeId morph) const;
+
+  // Finds all morphemes at the given position, as well as the scaled weight
+  // for each morpheme. The sum of the weights at that position add up to 1.
+  // Returns nullptr if there is no data for that position.
+  const Distribution* distributionAtPos(size_t argPos) const;
+
+private:
+  // There are only ever a handful of positions, so they are searched linearly.
+  std::vector<std::pair<size_t, Distribution>> Positions;
+};
+
+// Provides access to the usage statistics model. This is an interface over
+// the different ways a model can be stored and loaded; use Statistics::open()
+// to get the implementation that matches the checker configuration.
+class Statistics {
+public:
+  virtual ~Statistics() = default;
+
+  // Opens the model named by the configuration's ModelPath. Returns nullptr if
+  // there is no model path or the model could not be loaded. Models are cached
+  // process-wide, so every caller opening the same model file (with the same
+  // LoadModelInMemory setting) shares one loaded instance for as long as any of
+  // them holds on to it.
+  static std::shared_ptr<const Statistics>
+  open(const CheckerConfiguration& opts);
+
+  // Loads a new, unshared instance of the model named by the configuration's
+  // ModelPath, bypassing the process-wide cache. Returns nullptr if there is
+  // no model path or the model could not be loaded.
+  static std::unique_ptr<Statistics> load(const CheckerConfiguration& opts);
+
+  // Returns true if the Statistics class has a valid statistics database,
+  // false otherwise.
+  virtual bool valid() const = 0;
+
+  // Fetches every morpheme and weight for the given function at any of the
+  // given argument positions in a single pass over the model. The result is
+  // empty if the function does not exist or has no data at those positions.
+  // The morphemes are interned with the given interner. This may be called
+  // concurrently from multiple threads.
+  virtual CalleeStatistics
+  weightsForCallee(const std::string& funcName,
+                   const std::vector<size_t>& argPositions,
+                   MorphemeInterner& morphemes) const = 0;
+
+  // Returns false if the model definitely has no statistics for the given
+  // function, in which case there is no need to call weightsForCallee(). This
+  // is much cheaper than a lookup, but may return true for functions which
+  // are not in the model.
+  bool mayHaveStatistics(std::string_view funcName) const {
+    return Functions.mayContain(funcName);
+  }
+
+protected:
+  // Implementations call this once the model has loaded with the names of all
+  // of the functions it has statistics for. Until then, every function may
+  // have statistics.
+  template <typename Range> void setFunctionNames(const Range& names) {
+    FunctionFilter filter(std::size(names));
+    for (const auto& name : names)
+      filter.add(name);
+    Functions = std::move(filter);
+  }
+
+private:
+  FunctionFilter Functions;
+};
+} // end namespace swapped_arg
+
+#endif // GT_SWAPPED_ARG_STATISTICS_H
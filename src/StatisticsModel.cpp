@@ -0,0 +1,255 @@
+//===- StatisticsModel.cpp --------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#include "StatisticsModel.hpp"
+#include "BinaryModel.hpp"
+#include "Statistics.hpp"
+#include "sqlite3.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+using namespace swapped_arg;
+
+namespace {
+// A single row of the weights table, with the strings replaced by IDs.
+struct Row {
+  uint32_t Func, Arg, Morpheme;
+  float Value;
+};
+
+// Helper for writing the binary model, which keeps track of the current offset
+// so that the header can record where each table begins.
+class ModelWriter {
+  std::ofstream OS;
+  uint64_t Offset = 0;
+
+public:
+  explicit ModelWriter(const std::string& path)
+      : OS(path, std::ios::binary | std::ios::out | std::ios::trunc) {}
+
+  bool good() const { return OS.good(); }
+  uint64_t offset() const { return Offset; }
+
+  void write(const void* data, size_t size) {
+    OS.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    Offset += size;
+  }
+
+  template <typename Ty> void write(const std::vector<Ty>& table) {
+    write(table.data(), table.size() * sizeof(Ty));
+  }
+
+  // Overwrites previously written data at the given offset.
+  void patch(uint64_t at, const void* data, size_t size) {
+    OS.seekp(static_cast<std::streamoff>(at));
+    OS.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    OS.seekp(static_cast<std::streamoff>(Offset));
+  }
+
+  // Pads the output with zeros so the next table is suitably aligned.
+  void align(size_t alignment = 8) {
+    static const char zeros[8] = {};
+    write(zeros, (alignment - Offset % alignment) % alignment);
+  }
+};
+} // namespace
+
+bool model::convertToBinary(const std::string& sqlitePath,
+                            const std::string& binaryPath, std::string& error) {
+  sqlite3* db = nullptr;
+  if (SQLITE_OK != sqlite3_open_v2(sqlitePath.c_str(), &db,
+                                   SQLITE_OPEN_READONLY, nullptr)) {
+    error = "could not open '" + sqlitePath + "': " + sqlite3_errmsg(db);
+    (void)sqlite3_close(db);
+    return false;
+  }
+
+  // Read every row of the weights table, interning the strings as we go. The
+  // weights table is a view over weights_data and strings in the normalized
+  // schema, and a plain table in the flat schema, so this handles both.
+  std::unordered_map<std::string, uint32_t> ids;
+  std::vector<std::string> strings;
+  auto intern = [&ids, &strings](const unsigned char* text) {
+    auto [iter, inserted] = ids.try_emplace(
+        reinterpret_cast<const char*>(text),
+        static_cast<uint32_t>(strings.size()));
+    if (inserted)
+      strings.push_back(iter->first);
+    return iter->second;
+  };
+
+  std::vector<Row> rows;
+  sqlite3_stmt* query = nullptr;
+  int rc = sqlite3_prepare_v2(
+      db, "SELECT func, arg, morpheme, value FROM weights", -1, &query, nullptr);
+  while (rc == SQLITE_OK || rc == SQLITE_ROW) {
+    if ((rc = sqlite3_step(query)) != SQLITE_ROW)
+      break;
+    sqlite3_int64 arg = sqlite3_column_int64(query, 1);
+    if (arg < 0 || arg > std::numeric_limits<uint32_t>::max())
+      continue;
+    uint32_t func = intern(sqlite3_column_text(query, 0));
+    uint32_t morpheme = intern(sqlite3_column_text(query, 2));
+    rows.push_back({func, static_cast<uint32_t>(arg), morpheme,
+                    static_cast<float>(sqlite3_column_double(query, 3))});
+  }
+  if (rc != SQLITE_DONE)
+    error = "could not read the weights table from '" + sqlitePath +
+            "': " + sqlite3_errmsg(db);
+  (void)sqlite3_finalize(query);
+  (void)sqlite3_close(db);
+  if (rc != SQLITE_DONE)
+    return false;
+
+  if (strings.size() >= std::numeric_limits<uint32_t>::max() ||
+      rows.size() > std::numeric_limits<uint32_t>::max()) {
+    error = "the model is too large to convert";
+    return false;
+  }
+
+  // Sort the strings so that string IDs compare the same way as the strings
+  // do, then renumber the rows to match.
+  std::vector<uint32_t> order(strings.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&strings](uint32_t lhs, uint32_t rhs) {
+    return strings[lhs] < strings[rhs];
+  });
+  std::vector<uint32_t> renumbered(strings.size());
+  for (uint32_t newId = 0; newId < order.size(); ++newId)
+    renumbered[order[newId]] = newId;
+  for (Row& row : rows) {
+    row.Func = renumbered[row.Func];
+    row.Morpheme = renumbered[row.Morpheme];
+  }
+
+  // Sort the rows by function, then position, then morpheme. If the model has
+  // duplicate rows, the first one wins, same as when querying the database.
+  auto key = [](const Row& row) {
+    return std::make_tuple(row.Func, row.Arg, row.Morpheme);
+  };
+  std::stable_sort(rows.begin(), rows.end(),
+                   [&key](const Row& lhs, const Row& rhs) {
+                     return key(lhs) < key(rhs);
+                   });
+  rows.erase(std::unique(rows.begin(), rows.end(),
+                         [&key](const Row& lhs, const Row& rhs) {
+                           return key(lhs) == key(rhs);
+                         }),
+             rows.end());
+
+  // Build the string table.
+  std::vector<uint32_t> stringOffsets;
+  std::string stringData;
+  stringOffsets.reserve(strings.size() + 1);
+  for (uint32_t oldId : order) {
+    stringOffsets.push_back(static_cast<uint32_t>(stringData.size()));
+    stringData += strings[oldId];
+    stringData += '\0';
+    if (stringData.size() > std::numeric_limits<uint32_t>::max()) {
+      error = "the model's strings are too large to convert";
+      return false;
+    }
+  }
+  stringOffsets.push_back(static_cast<uint32_t>(stringData.size()));
+
+  // Build the function, position, and entry tables from the sorted rows.
+  std::vector<binary_model::Function> functions;
+  std::vector<binary_model::Position> positions;
+  std::vector<binary_model::Entry> entries;
+  entries.reserve(rows.size());
+  for (const Row& row : rows) {
+    if (functions.empty() || functions.back().Name != row.Func)
+      functions.push_back(
+          {row.Func, static_cast<uint32_t>(positions.size()), 0});
+    binary_model::Function& func = functions.back();
+    if (func.PositionCount == 0 || positions.back().Arg != row.Arg) {
+      positions.push_back({row.Arg, static_cast<uint32_t>(entries.size()), 0});
+      ++func.PositionCount;
+    }
+    ++positions.back().EntryCount;
+    entries.push_back({row.Morpheme, row.Value});
+  }
+
+  binary_model::Header header{};
+  std::copy(std::begin(binary_model::Magic), std::end(binary_model::Magic),
+            header.Magic);
+  header.Version = binary_model::CurrentVersion;
+  header.ByteOrderMark = binary_model::ByteOrderMark;
+  header.StringCount = static_cast<uint32_t>(strings.size());
+  header.FunctionCount = static_cast<uint32_t>(functions.size());
+  header.PositionCount = static_cast<uint32_t>(positions.size());
+  header.EntryCount = static_cast<uint32_t>(entries.size());
+  header.StringDataSize = stringData.size();
+
+  // The header is written twice: once as a placeholder and again after all of
+  // the table offsets are known.
+  ModelWriter writer(binaryPath);
+  writer.write(&header, sizeof(header));
+  writer.align();
+  header.StringOffsetsOffset = writer.offset();
+  writer.write(stringOffsets);
+  header.StringDataOffset = writer.offset();
+  writer.write(stringData.data(), stringData.size());
+  writer.align();
+  header.FunctionsOffset = writer.offset();
+  writer.write(functions);
+  writer.align();
+  header.PositionsOffset = writer.offset();
+  writer.write(positions);
+  writer.align();
+  header.EntriesOffset = writer.offset();
+  writer.write(entries);
+  writer.patch(0, &header, sizeof(header));
+  if (!writer.good()) {
+    error = "could not write '" + binaryPath + "'";
+    return false;
+  }
+  return true;
+}
+
+bool model::optimize(const std::string& sqlitePath, std::string& error) {
+  sqlite3* db = nullptr;
+  if (SQLITE_OK != sqlite3_open_v2(sqlitePath.c_str(), &db,
+                                   SQLITE_OPEN_READWRITE, nullptr)) {
+    error = "could not open '" + sqlitePath + "': " + sqlite3_errmsg(db);
+    (void)sqlite3_close(db);
+    return false;
+  }
+
+  // The checker looks up every row for a function, so an index on the function
+  // that also includes the rest of the columns lets SQLite answer the query
+  // from the index alone. The normalized schema stores the rows in
+  // weights_data; otherwise weights is a plain table.
+  bool normalized = isNormalizedSchema(db);
+  const char* sql =
+      normalized ? "CREATE INDEX IF NOT EXISTS weights_data_func_index ON "
+                   "weights_data(func, arg, morpheme, value); ANALYZE;"
+                 : "CREATE INDEX IF NOT EXISTS weights_func_index ON "
+                   "weights(func, arg, morpheme, value); ANALYZE;";
+  char* message = nullptr;
+  bool ret = SQLITE_OK == sqlite3_exec(db, sql, nullptr, nullptr, &message);
+  if (!ret)
+    error = "could not optimize '" + sqlitePath + "': " +
+            (message ? message : sqlite3_errmsg(db));
+  sqlite3_free(message);
+  (void)sqlite3_close(db);
+  return ret;
+}
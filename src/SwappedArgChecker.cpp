@@ -15,220 +15,88 @@
 //===----------------------------------------------------------------------===//
 #include "SwappedArgChecker.hpp"
 #include "IdentifierSplitting.hpp"
-#include "sqlite3.h"
+#include "Statistics.hpp"
 #include <algorithm>
 #include <cassert>
-#include <cstdio>
-#include <iostream>
 #include <iterator>
-#include <sstream>
+#include <limits>
+#include <numeric>
+#include <thread>
 #include <utility>
 
-namespace swapped_arg {
-class Statistics {
-  sqlite3* db = nullptr;
-  sqlite3_stmt* morph_value_query = nullptr;
-  sqlite3_stmt* value_query = nullptr;
+using namespace swapped_arg;
+
+namespace {
+// A lazily generated range of the zero-based indicies for all the pair-wise
+// combinations from a list of totalCount length, in lexicographic order:
+// (0, 1), (0, 2), ..., (0, n-1), (1, 2), ..., (n-2, n-1).
+class PairwiseCombinations {
+  size_t TotalCount;
 
 public:
-  explicit Statistics(const std::string& path) {
-    // We purposefully do not care about a failure to load the database at this
-    // stage. The valid() method can be used to determine if the Statistics
-    // object is valid or not.
-    if (!path.empty() &&
-        SQLITE_OK ==
-            sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr)) {
-      (void)sqlite3_prepare_v2(
-          db,
-          "SELECT morpheme, value FROM weights WHERE func == ? AND arg == ?",
-          -1, &morph_value_query, nullptr);
-      (void)sqlite3_prepare_v2(db,
-                               "SELECT value FROM weights WHERE func == ? AND "
-                               "arg == ? AND morpheme == ?",
-                               -1, &value_query, nullptr);
-    }
-  }
-  ~Statistics() {
-    if (morph_value_query) {
-      (void)sqlite3_finalize(morph_value_query);
+  class iterator {
+    std::pair<size_t, size_t> Current;
+    size_t TotalCount;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::pair<size_t, size_t>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    iterator(std::pair<size_t, size_t> current, size_t totalCount)
+        : Current(current), TotalCount(totalCount) {}
+
+    reference operator*() const { return Current; }
+    pointer operator->() const { return &Current; }
+    iterator& operator++() {
+      if (++Current.second == TotalCount) {
+        ++Current.first;
+        Current.second = Current.first + 1;
+      }
+      return *this;
     }
-    if (value_query) {
-      (void)sqlite3_finalize(value_query);
+    iterator operator++(int) {
+      iterator ret = *this;
+      ++*this;
+      return ret;
     }
-    if (db) {
-      (void)sqlite3_close(db);
+    bool operator==(const iterator& other) const {
+      return Current == other.Current;
     }
-  }
-
-  // Returns true if the Statistics class has a valid statistics database,
-  // false otherwise.
-  bool valid() const {
-    return db != nullptr && morph_value_query != nullptr &&
-           value_query != nullptr;
-  }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+  };
 
-  // Finds how often the given morpheme is used at the specified position for a
-  // given function call. Returns nullopt if the function does not exist or the
-  // argument position is invalid.
-  std::optional<float> weightForMorphemeAtPos(const std::string& funcName,
-                                              size_t argPos,
-                                              const std::string& morpheme) {
-    assert(valid() && "no valid database loaded");
-
-    // Helper RAII structure which binds the query arguments to the query on
-    // construction and resets the query on destruction.
-    class Binder {
-      sqlite3_stmt* query;
-
-    public:
-      Binder(sqlite3_stmt* stmt, const std::string& funcName, size_t argPos,
-             const std::string& morpheme)
-          : query(stmt) {
-        (void)sqlite3_bind_text(query, 1, funcName.c_str(), -1,
-                                SQLITE_TRANSIENT);
-        (void)sqlite3_bind_int64(query, 2, static_cast<sqlite3_int64>(argPos));
-        (void)sqlite3_bind_text(query, 3, morpheme.c_str(), -1,
-                                SQLITE_TRANSIENT);
-      }
-      ~Binder() {
-        (void)sqlite3_clear_bindings(query);
-        (void)sqlite3_reset(query);
-      }
-    } binder(value_query, funcName, argPos, morpheme);
+  explicit PairwiseCombinations(size_t totalCount) : TotalCount(totalCount) {}
 
-    for (;;) {
-      int rc = sqlite3_step(value_query);
-      if (rc == SQLITE_DONE) {
-        break;
-      } else if (rc == SQLITE_ROW) {
-        return static_cast<float>(sqlite3_column_double(value_query, 0));
-      } else {
-        break;
-      }
-    }
-    return std::nullopt;
+  iterator begin() const {
+    return TotalCount < 2 ? end() : iterator({0, 1}, TotalCount);
   }
-
-  // Finds all morphemes for the given function call and argument position, as
-  // well as the scaled weight for each morpheme. The sum of the weights at
-  // that position add up to 1. Returns false if the function does not exist or
-  // the argument position is invalid; true otherwise.
-  bool
-  morphemesAndWeightsAtPos(const std::string& funcName, size_t argPos,
-                           std::vector<std::pair<std::string, float>>& res) {
-    assert(valid() && "no valid database loaded");
-
-    // Helper RAII structure which binds the query arguments to the query on
-    // construction and resets the query on destruction.
-    class Binder {
-      sqlite3_stmt* query;
-
-    public:
-      Binder(sqlite3_stmt* stmt, const std::string& funcName, size_t argPos)
-          : query(stmt) {
-        (void)sqlite3_bind_text(query, 1, funcName.c_str(), -1,
-                                SQLITE_TRANSIENT);
-        (void)sqlite3_bind_int64(query, 2, static_cast<sqlite3_int64>(argPos));
-      }
-      ~Binder() {
-        (void)sqlite3_clear_bindings(query);
-        (void)sqlite3_reset(query);
-      }
-    } binder(morph_value_query, funcName, argPos);
-
-    bool ret = false;
-    for (;;) {
-      int rc = sqlite3_step(morph_value_query);
-      if (rc == SQLITE_DONE) {
-        break;
-      } else if (rc == SQLITE_ROW) {
-        ret = true;
-        res.emplace_back(
-            std::string(reinterpret_cast<const char*>(
-                sqlite3_column_text(morph_value_query, 0))),
-            static_cast<float>(sqlite3_column_double(morph_value_query, 1)));
-      } else {
-        return false;
-      }
-    }
-    return ret;
+  // Incrementing past the last pair, (n-2, n-1), yields (n-1, n).
+  iterator end() const {
+    return TotalCount < 2 ? iterator({0, 0}, TotalCount)
+                          : iterator({TotalCount - 1, TotalCount}, TotalCount);
   }
 };
-} // namespace swapped_arg
-
-using namespace swapped_arg;
-
-std::string test::createStatsDB(std::initializer_list<test::StatsDBRow> rows) {
-  std::string file_name = ::tmpnam(nullptr);
-
-  sqlite3* db = nullptr;
-  int rc = sqlite3_open(file_name.c_str(), &db);
-  if (rc != SQLITE_OK)
-    return "";
-
-  rc = sqlite3_exec(db,
-                    "CREATE TABLE weights ("
-                    "func TEXT NOT NULL,"
-                    "arg INTEGER NOT NULL CHECK(arg >= 0),"
-                    "morpheme TEXT NOT NULL,"
-                    "value REAL NOT NULL CHECK(value >= 0 AND value <= 1)"
-                    ");",
-                    nullptr, nullptr, nullptr);
-  assert(rc == SQLITE_OK && "Could not create a table in the database");
-
-  for (const auto& row : rows) {
-    auto [func, arg, morpheme, value] = row;
-    std::stringstream ss;
-    ss << "INSERT INTO weights "
-       << "('func', 'arg', 'morpheme', 'value')"
-       << "VALUES ('" << func << "', '" << arg << "', '" << morpheme << "', '"
-       << value << "');";
-    rc = sqlite3_exec(db, ss.str().c_str(), nullptr, nullptr, nullptr);
-    assert(rc == SQLITE_OK && "Could not add a row to the database");
-  }
-
-  (void)sqlite3_close(db);
-
-  return file_name;
-}
-
-// Calculates the zero-based indicies for all the pair-wise combinations from
-// a list of totalCount length.
-static std::vector<std::pair<size_t, size_t>>
-pairwise_combinations(size_t totalCount) {
-  std::vector<std::pair<size_t, size_t>> ret;
-  std::vector<bool> bitset(2, true);
-  bitset.resize(totalCount, false);
-
-  do {
-    size_t first = ~0U, second = ~0U;
-    for (size_t idx = 0; idx < totalCount; ++idx) {
-      if (bitset[idx]) {
-        if (first == ~0U)
-          first = idx;
-        else {
-          assert(second == ~0U);
-          second = idx;
-        }
-      }
-    }
-    assert(first != ~0U && second != ~0U);
-    ret.push_back(std::make_pair(first, second));
-  } while (std::prev_permutation(bitset.begin(), bitset.end()));
-  return ret;
-}
+} // namespace
 
 // Returns a Result if the checker reported any issues; nullopt otherwise.
 std::optional<Result> Checker::checkForCoverBasedSwap(
-    const std::pair<MorphemeSet, MorphemeSet>& params,
-    const std::pair<MorphemeSet, MorphemeSet>& args, const CallSite& site) {
+    const DeclMorphemes& decl, SiteMorphemes& table,
+    const MorphemeSetPair& args, const CallSite& site,
+    const CalleeStatistics* calleeStats) {
+  size_t pos1 = args.first.Position, pos2 = args.second.Position;
+  assert(decl.param(pos1) && decl.param(pos1)->Usable && decl.param(pos2) &&
+         decl.param(pos2)->Usable && "Expected usable parameters");
+
   // We have already verified that the morpheme sets are not empty, but we
   // also need to verify that the number of morphemes is the same between each
   // parameter and argument.
-  const std::set<std::string>&param1Morphs = params.first.Morphemes,
-        &param2Morphs = params.second.Morphemes;
-  const std::set<std::string>&arg1Morphs = args.first.Morphemes,
-        &arg2Morphs = args.second.Morphemes;
+  const MorphemeIdSet &param1Morphs = decl.param(pos1)->Morphemes,
+                     &param2Morphs = decl.param(pos2)->Morphemes;
+  const MorphemeIdSet &arg1Morphs = args.first.Morphemes,
+                     &arg2Morphs = args.second.Morphemes;
   assert(!param1Morphs.empty() && !param2Morphs.empty() &&
          !arg1Morphs.empty() && !arg2Morphs.empty());
 
@@ -237,43 +105,64 @@ std::optional<Result> Checker::checkForCoverBasedSwap(
       param1Morphs.size() != arg1Morphs.size())
     return std::nullopt;
 
-  // Remove any low entropy or duplicate param morphemes.
-  std::set<std::string> uniqueMorphsParam1 =
-                            nonLowEntropyDifference(param1Morphs, param2Morphs),
-                        uniqueMorphsParam2 =
-                            nonLowEntropyDifference(param2Morphs, param1Morphs);
-  std::set<std::string> uniqueMorphsArg1 =
-                            nonLowEntropyDifference(arg1Morphs, arg2Morphs),
-                        uniqueMorphsArg2 =
-                            nonLowEntropyDifference(arg2Morphs, arg1Morphs);
+  // When swapped, every unique morpheme of each parameter has to be found in
+  // the other argument. Morphemes only match when they are identical, so if
+  // the other argument's signature is missing any bit of the parameter's
+  // signature, the swapped match is zero and the pair can be rejected without
+  // uniquing and comparing the morphemes.
+  ++CoverPairs;
+  if (Opts.SwappedMorphemeMatchMin > 0.0f &&
+      ((decl.uniqueSignature(pos2, pos1) & ~table.Args[pos1].Signature) ||
+       (decl.uniqueSignature(pos1, pos2) & ~table.Args[pos2].Signature))) {
+    ++PrunedCoverPairs;
+    return std::nullopt;
+  }
+
+  // Remove any low entropy or duplicate param morphemes. These only depend on
+  // the declaration, so they were computed along with the declaration's
+  // morphemes.
+  const MorphemeIdSet &uniqueMorphsParam1 = decl.uniqueMorphemes(pos1, pos2),
+                     &uniqueMorphsParam2 = decl.uniqueMorphemes(pos2, pos1);
+  MorphemeIdSet uniqueMorphsArg1 =
+                    nonLowEntropyDifference(arg1Morphs, arg2Morphs),
+                uniqueMorphsArg2 =
+                    nonLowEntropyDifference(arg2Morphs, arg1Morphs);
 
   // If there are not enough morphemes left after uniquing, then bail out.
   if (uniqueMorphsParam1.empty() || uniqueMorphsParam2.empty() ||
       uniqueMorphsArg1.empty() || uniqueMorphsArg2.empty())
     return std::nullopt;
 
+  // When neither the arguments nor the parameters have any morphemes in
+  // common, uniquing removed nothing, so the matches computed for the whole
+  // call site can be used instead of matching the morphemes again.
+  bool useSiteMatches = uniqueMorphsArg1.size() == arg1Morphs.size() &&
+                        uniqueMorphsParam1.size() == param1Morphs.size();
+  auto match = [&](const MorphemeIdSet& arg, size_t argPos,
+                   const MorphemeIdSet& param, size_t paramPos, Bias bias) {
+    if (!useSiteMatches)
+      return morphemesMatch(arg, param, bias);
+    return siteMatch(decl, table, argPos, paramPos, bias);
+  };
+
   // If the morphemes seem at all good in their current locations, bail out.
   float mm_ai_pi;
-  if ((mm_ai_pi = morphemesMatch(uniqueMorphsArg1, uniqueMorphsParam1,
-                                 Bias::Optimistic)) >
-      Opts.ExistingMorphemeMatchMax)
+  if ((mm_ai_pi = match(uniqueMorphsArg1, pos1, uniqueMorphsParam1, pos1,
+                        Bias::Optimistic)) > Opts.ExistingMorphemeMatchMax)
     return std::nullopt;
   float mm_aj_pj;
-  if ((mm_aj_pj = morphemesMatch(uniqueMorphsArg2, uniqueMorphsParam2,
-                                 Bias::Optimistic)) >
-      Opts.ExistingMorphemeMatchMax)
+  if ((mm_aj_pj = match(uniqueMorphsArg2, pos2, uniqueMorphsParam2, pos2,
+                        Bias::Optimistic)) > Opts.ExistingMorphemeMatchMax)
     return std::nullopt;
 
   // If the morphemes seem at all bad when you swap them, bail out.
   float mm_ai_pj;
-  if ((mm_ai_pj = morphemesMatch(uniqueMorphsArg1, uniqueMorphsParam2,
-                                 Bias::Pessimistic)) <
-      Opts.SwappedMorphemeMatchMin)
+  if ((mm_ai_pj = match(uniqueMorphsArg1, pos1, uniqueMorphsParam2, pos2,
+                        Bias::Pessimistic)) < Opts.SwappedMorphemeMatchMin)
     return std::nullopt;
   float mm_aj_pi;
-  if ((mm_aj_pi = morphemesMatch(uniqueMorphsArg2, uniqueMorphsParam1,
-                                 Bias::Pessimistic)) <
-      Opts.SwappedMorphemeMatchMin)
+  if ((mm_aj_pi = match(uniqueMorphsArg2, pos2, uniqueMorphsParam1, pos1,
+                        Bias::Pessimistic)) < Opts.SwappedMorphemeMatchMin)
     return std::nullopt;
 
   // If we got here but there are numeric suffixes on the arguments or the
@@ -285,8 +174,8 @@ std::optional<Result> Checker::checkForCoverBasedSwap(
     return std::isdigit(suf1) && std::isdigit(suf2) &&
            one.substr(0, one.length() - 1) == two.substr(0, two.length() - 1);
   };
-  std::string param1 = *getParamName(site, params.first.Position),
-              param2 = *getParamName(site, params.second.Position);
+  std::string param1 = *getParamName(site, pos1),
+              param2 = *getParamName(site, pos2);
   if (suffixCheck(param1, param2))
     return std::nullopt;
   std::string arg1 = *getLastArgName(site, args.first.Position),
@@ -302,7 +191,7 @@ std::optional<Result> Checker::checkForCoverBasedSwap(
   // no diagnostic will be reported.
   std::optional<float> stats_score;
 
-  if (Stats) {
+  if (calleeStats) {
     // If the stats database is available then it can be used to determine if
     // unique argument morphemes for argument 1 are more common at position 1
     // than at position 2. Similarly, the unique argument morphemes for argument
@@ -312,20 +201,21 @@ std::optional<Result> Checker::checkForCoverBasedSwap(
     // what's done by the stats-based checker, but in this case we check how
     // much more common the morpheme is where it is (opposite to the stats
     // checker).
-    assert(Stats->valid() && "Expected the stats to be valid");
     std::for_each(
         uniqueMorphsArg1.begin(), uniqueMorphsArg1.end(),
-        [&](const std::string& morph) {
+        [&](MorphemeInterner::Id morph) {
           if (auto val = morphemeConfidenceAtPosition(
-                  site, morph, args.first.Position, args.second.Position)) {
+                  *calleeStats, morph, args.first.Position,
+                  args.second.Position)) {
             stats_score = std::max(stats_score.value_or(0.0f), *val);
           }
         });
     std::for_each(
         uniqueMorphsArg2.begin(), uniqueMorphsArg2.end(),
-        [&](const std::string& morph) {
+        [&](MorphemeInterner::Id morph) {
           if (auto val = morphemeConfidenceAtPosition(
-                  site, morph, args.second.Position, args.first.Position)) {
+                  *calleeStats, morph, args.second.Position,
+                  args.first.Position)) {
             stats_score = std::max(stats_score.value_or(0.0f), *val);
           }
         });
@@ -338,52 +228,32 @@ std::optional<Result> Checker::checkForCoverBasedSwap(
     }
   }
 
-  Result r;
-  r.arg1 = args.first.Position + 1;
-  r.arg2 = args.second.Position + 1;
-  r.score = std::make_unique<ParameterNameBasedScoreCard>(worst_psi, stats_score);
-  r.morphemes1 = uniqueMorphsArg1;
-  r.morphemes2 = uniqueMorphsArg2;
-#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 7
-  // Hack around a GCC 7.x bug where the presence of a move-only data member
-  // causes the std::optional constructor to be removed from consideration.
-  // This is the only version of GCC we have to worry about (we don't support
-  // older versions and the bug was fixed in newer versions).
-  return std::move(r);
-#else
-  return r;
-#endif
+  return Result{args.first.Position + 1, args.second.Position + 1,
+                morphemeList(uniqueMorphsArg1), morphemeList(uniqueMorphsArg2),
+                ParameterNameBasedScoreCard(worst_psi, stats_score)};
 }
 
-float Checker::anyAreSynonyms(
-    const std::string& morpheme,
-    const std::set<std::string>& potentialSynonyms) const {
-  // FIXME: this is a very basic implementation currently.
-  for (const std::string& synonym : potentialSynonyms) {
-    if (synonym == morpheme) {
-      return 1.0f;
-    }
-  }
-  return 0.0f;
+float Checker::anyAreSynonyms(MorphemeInterner::Id morpheme,
+                              const MorphemeIdSet& potentialSynonyms) const {
+  // FIXME: this is a very basic implementation currently. If this starts
+  // matching morphemes which are not identical, the signature check in
+  // checkForCoverBasedSwap() has to be revisited.
+  return potentialSynonyms.contains(morpheme) ? 1.0f : 0.0f;
 }
 
-std::set<std::string>
-Checker::nonLowEntropyDifference(const std::set<std::string>& lhs,
-                                 const std::set<std::string>& rhs) const {
-  std::set<std::string> ret;
+MorphemeIdSet
+Checker::nonLowEntropyDifference(const MorphemeIdSet& lhs,
+                                 const MorphemeIdSet& rhs) const {
   // FIXME: consider whether we want to handle low-entropy morphemes. For now,
   // do a set difference.
-  std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
-                      std::inserter(ret, ret.begin()));
-  return ret;
+  return MorphemeIdSet::difference(lhs, rhs);
 }
 
-float Checker::morphemesMatch(const std::set<std::string>& arg,
-                              const std::set<std::string>& param,
-                              Bias bias) const {
+float Checker::morphemesMatch(const MorphemeIdSet& arg,
+                              const MorphemeIdSet& param, Bias bias) const {
   BiasComp comp(bias, Opts);
   std::optional<float> extreme;
-  for (const std::string& paramMorph : param) {
+  for (MorphemeInterner::Id paramMorph : param) {
     float val = anyAreSynonyms(paramMorph, arg);
     if (!extreme || comp(val, *extreme)) {
       extreme = val;
@@ -393,6 +263,10 @@ float Checker::morphemesMatch(const std::set<std::string>& arg,
   return *extreme;
 }
 
+MorphemeList Checker::morphemeList(const MorphemeIdSet& morphemes) const {
+  return MorphemeList(morphemes, Morphemes);
+}
+
 Checker::MorphemeSet
 Checker::morphemeSetDifference(const MorphemeSet& one,
                                const MorphemeSet& two) const {
@@ -400,21 +274,16 @@ Checker::morphemeSetDifference(const MorphemeSet& one,
   // We are removing the duplicates from the first set to report the difference,
   // so the position followed the first set.
   ret.Position = one.Position;
-  std::set_difference(one.Morphemes.begin(), one.Morphemes.end(),
-                      two.Morphemes.begin(), two.Morphemes.end(),
-                      std::inserter(ret.Morphemes, ret.Morphemes.begin()));
+  ret.Morphemes = MorphemeIdSet::difference(one.Morphemes, two.Morphemes);
   return ret;
 }
 
 std::optional<float>
-Checker::morphemeConfidenceAtPosition(const CallSite& callSite,
-                                      const std::string& morph, size_t pos,
+Checker::morphemeConfidenceAtPosition(const CalleeStatistics& calleeStats,
+                                      MorphemeInterner::Id morph, size_t pos,
                                       size_t comparedToPos) const {
-  assert(Stats && Stats->valid() && "Expected to have valid statistics");
-  auto pos1 = Stats->weightForMorphemeAtPos(
-           callSite.callDecl.fullyQualifiedName, pos, morph),
-       pos2 = Stats->weightForMorphemeAtPos(
-           callSite.callDecl.fullyQualifiedName, comparedToPos, morph);
+  auto pos1 = calleeStats.weightForMorphemeAtPos(pos, morph),
+       pos2 = calleeStats.weightForMorphemeAtPos(comparedToPos, morph);
   // If pos1 exists but pos2 does not exist, that means the confidence at pos is
   // high because the morpheme never appears at comparedToPos. If pos2 exists
   // but pos1 does not, that means the confidence at pos is low because the
@@ -428,44 +297,52 @@ Checker::morphemeConfidenceAtPosition(const CallSite& callSite,
   return std::nullopt;
 }
 
-float Checker::similarity(const std::string& morph1,
-                          const std::string& morph2) const {
+float Checker::similarity(MorphemeInterner::Id morph1,
+                          MorphemeInterner::Id morph2) const {
   // TODO: implement this
   return morph1 == morph2 ? 1.0f : 0.0f;
 }
 
-float Checker::fit(const std::string& morph, const CallSite& site,
-                   size_t argPos) const {
-  assert(Stats && Stats->valid() && "Expected to have valid statistics");
-  std::string funcName = site.callDecl.fullyQualifiedName;
-  std::vector<std::pair<std::string, float>> morphsAndWeightsAtPos;
-  if (!Stats->morphemesAndWeightsAtPos(funcName, argPos, morphsAndWeightsAtPos))
-    return 0.0f;
+template <typename Fn>
+void Checker::forEachSimilarMorpheme(MorphemeInterner::Id morph,
+                                     Fn fn) const {
+  // While similarity() is exact matching, the only similar morpheme is the
+  // morpheme itself. Once similarity() recognizes abbreviations and synonyms,
+  // the similar morphemes for each morpheme in the model should be
+  // precomputed so that this remains a lookup.
+  fn(morph, similarity(morph, morph));
+}
 
+float Checker::fit(MorphemeInterner::Id morph,
+                   const CalleeStatistics& calleeStats, size_t argPos) const {
+  // Every morpheme which is not similar contributes nothing to the fitness, so
+  // only the similar morphemes need to be looked up.
   float ret = 0.0f;
-  for (const auto& [m, weight] : morphsAndWeightsAtPos) {
-    ret += similarity(morph, m) * weight;
-  }
+  forEachSimilarMorpheme(
+      morph, [&](MorphemeInterner::Id similar, float score) {
+        if (std::optional<float> weight =
+                calleeStats.weightForMorphemeAtPos(argPos, similar))
+          ret += score * *weight;
+      });
   return ret;
 }
 
 std::optional<Result> Checker::checkForStatisticsBasedSwap(
-    const std::pair<MorphemeSet, MorphemeSet>& params,
-    const std::pair<MorphemeSet, MorphemeSet>& args, const CallSite& callSite) {
+    const MorphemeSetPair& args, const CalleeStatistics& calleeStats) {
   MorphemeSet uniqArgMorphs1 = morphemeSetDifference(args.first, args.second),
               uniqArgMorphs2 = morphemeSetDifference(args.second, args.first);
 
-  for (const std::string& argMorph1 : uniqArgMorphs1.Morphemes) {
-    for (const std::string& argMorph2 : uniqArgMorphs2.Morphemes) {
+  for (MorphemeInterner::Id argMorph1 : uniqArgMorphs1.Morphemes) {
+    for (MorphemeInterner::Id argMorph2 : uniqArgMorphs2.Morphemes) {
       // Check to see how much more common the first morpheme is at position 2
       // than position 1, and how much more common the second morpheme is at
       // position 1 than position 2. If they seem to not be commonly swapped,
       // move on.
       std::optional<float> psi1 = morphemeConfidenceAtPosition(
-                               callSite, argMorph1, uniqArgMorphs2.Position,
+                               calleeStats, argMorph1, uniqArgMorphs2.Position,
                                uniqArgMorphs1.Position),
                            psi2 = morphemeConfidenceAtPosition(
-                               callSite, argMorph2, uniqArgMorphs1.Position,
+                               calleeStats, argMorph2, uniqArgMorphs1.Position,
                                uniqArgMorphs2.Position);
       if (!psi1 || !psi2 || *psi1 <= Opts.StatsSwappedMorphemeThreshold ||
           *psi2 <= Opts.StatsSwappedMorphemeThreshold) {
@@ -474,41 +351,22 @@ std::optional<Result> Checker::checkForStatisticsBasedSwap(
 
       // Only consider the case where the remainder of the morphemes are the
       // same between both arguments.
-      std::set<std::string> one, two;
-      std::remove_copy(uniqArgMorphs1.Morphemes.begin(),
-                       uniqArgMorphs1.Morphemes.end(),
-                       std::inserter(one, one.begin()), argMorph1);
-      std::remove_copy(uniqArgMorphs2.Morphemes.begin(),
-                       uniqArgMorphs2.Morphemes.end(),
-                       std::inserter(two, two.begin()), argMorph2);
-      if (!std::equal(one.begin(), one.end(), two.begin(), two.end())) {
+      if (MorphemeIdSet::difference(uniqArgMorphs1.Morphemes, {argMorph1}) !=
+          MorphemeIdSet::difference(uniqArgMorphs2.Morphemes, {argMorph2})) {
         continue;
       }
 
       // Determine the fitness of the first arg morpheme compared to the second
       // and vice versa to see if it exceeds a threshold.
-      float fit1 = fit(argMorph1, callSite, args.second.Position),
-            fit2 = fit(argMorph2, callSite, args.first.Position);
+      float fit1 = fit(argMorph1, calleeStats, args.second.Position),
+            fit2 = fit(argMorph2, calleeStats, args.first.Position);
       if (fit1 > Opts.StatsSwappedFitnessThreshold &&
           fit2 > Opts.StatsSwappedFitnessThreshold) {
         // Return the statistical swap result.
-        Result r;
-        r.arg1 = args.first.Position + 1;
-        r.arg2 = args.second.Position + 1;
-        r.score = std::make_unique<UsageStatisticsBasedScoreCard>(fit1, fit2,
-                                                                  *psi1, *psi2);
-        r.morphemes1 = uniqArgMorphs1.Morphemes;
-        r.morphemes2 = uniqArgMorphs2.Morphemes;
-#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ == 7
-        // Hack around a GCC 7.x bug where the presence of a move-only data
-        // member causes the std::optional constructor to be removed from
-        // consideration. This is the only version of GCC we have to worry about
-        // (we don't support older versions and the bug was fixed in newer
-        // versions).
-        return std::move(r);
-#else
-        return r;
-#endif
+        return Result{args.first.Position + 1, args.second.Position + 1,
+                      morphemeList(uniqArgMorphs1.Morphemes),
+                      morphemeList(uniqArgMorphs2.Morphemes),
+                      UsageStatisticsBasedScoreCard(fit1, fit2, *psi1, *psi2)};
       }
     }
   }
@@ -517,121 +375,533 @@ std::optional<Result> Checker::checkForStatisticsBasedSwap(
 
 // Removes low-quality morphemes from the given set. Returns true if removing
 // the morphemes leaves the set empty, false otherwise.
-static bool removeLowQualityMorphemes(std::set<std::string>& morphemes) {
+static bool removeLowQualityMorphemes(MorphemeIdSet& morphemes) {
   // FIXME: implement the reduction heuristics here.
   return morphemes.empty();
 }
 
-Checker::Checker(const CheckerConfiguration& opts) : Opts(opts) {
-  if (!Opts.ModelPath.empty()) {
-    Stats = new Statistics(Opts.ModelPath);
-    if (!Stats->valid()) {
-      // If we couldn't load valid stats, pretend there were no stats loaded
-      // at all rather than leave an invalid database around.
-      delete Stats;
-      Stats = nullptr;
+Checker::Checker(const CheckerConfiguration& opts)
+    : Opts(opts), Splitter(opts.IdentifierMemoCapacity) {
+  // Statistics::open() returns null if there is no model or it is invalid, in
+  // which case we behave as though no model was configured.
+  Stats = Statistics::open(Opts);
+}
+
+Checker::~Checker() = default;
+
+std::shared_ptr<const CalleeStatistics>
+Checker::getCalleeStatistics(const std::string& funcName, size_t argCount) {
+  if (!Stats)
+    return nullptr;
+  if (!Stats->mayHaveStatistics(funcName)) {
+    ++SkippedCalleeLookups;
+    return nullptr;
+  }
+
+  if (Opts.CalleeCacheCapacity) {
+    std::lock_guard<std::mutex> guard(CalleeCacheLock);
+    auto iter = CalleeCache.find(funcName);
+    if (iter != CalleeCache.end() && iter->second.first >= argCount) {
+      ++CachedCalleeLookups;
+      return iter->second.second;
     }
   }
-}
 
-Checker::~Checker() { delete Stats; }
+  // Query the model without holding the lock so that other threads are not
+  // held up by it.
+  std::vector<size_t> positions(argCount);
+  std::iota(positions.begin(), positions.end(), 0);
+  auto stats = std::make_shared<const CalleeStatistics>(
+      Stats->weightsForCallee(funcName, positions, Morphemes));
+  ++CalleeLookups;
+  if (stats->empty())
+    ++EmptyCalleeLookups;
+
+  if (Opts.CalleeCacheCapacity) {
+    std::lock_guard<std::mutex> guard(CalleeCacheLock);
+    // Rather than tracking how recently each callee was used, start over once
+    // the cache fills up; calls to the same callee tend to be close together.
+    if (CalleeCache.size() >= Opts.CalleeCacheCapacity)
+      CalleeCache.clear();
+    auto& entry = CalleeCache[funcName];
+    if (!entry.second || entry.first < argCount)
+      entry = std::make_pair(argCount, stats);
+  }
+  return stats;
+}
 
-std::vector<Result> Checker::CheckSite(const CallSite& site, Check whichCheck) {
-  // If there aren't at least two arguments to the call, there's no swapping
-  // possible, so bail out early.
+void Checker::splitSite(const CallSite& site, size_t argCount,
+                        SiteMorphemes& table) {
   const std::vector<CallSite::ArgumentNames>& args = site.positionalArgNames;
-  if (args.size() < 2)
-    return {};
+  assert(argCount <= args.size() && "Expected a count of the site's arguments");
+  table.Args.resize(argCount);
 
-  // Walk through each combination of argument pairs from the call site.
-  const CallDeclDescriptor& decl = site.callDecl;
-  std::vector<Result> results;
-  std::vector<std::pair<size_t, size_t>> argPairs =
-      pairwise_combinations(args.size());
-  for (const auto& pairwiseArgs : argPairs) {
-    // If there is a corresponding parameter for each argument, we may be
-    // able to run the cover-based checker. Consider:
-    // void foo(int i, ...); foo(1, 2, 3, 4);
-    // as an example of when an argument may not have a corresponding parameter.
-    // Also, check that if we have a parameter for an argument, that the
-    // parameter has a name. Consider:
-    // void foo(int i, int, int, int j); foo(1, 2, 3, 4);
-    // as an example of when an argument may not have a corresponding named
-    // parameter.
-    std::string param1, param2;
-    if (std::optional<std::string> n = getParamName(site, pairwiseArgs.first))
-      param1 = *n;
-    if (std::optional<std::string> n = getParamName(site, pairwiseArgs.second))
-      param2 = *n;
-
-    // FIXME: currently, the stub for IdentifierSplitter has no state and
-    // requires no parameterization. If that continues to be true after
-    // adding the real implementation, this should be replaced with a free
-    // function. If it does have state, this may also be more natural as a
-    // data member rather than a local.
-    IdentifierSplitter splitter;
-    MorphemeSet param1Morphemes{splitter.split(param1), pairwiseArgs.first},
-        param2Morphemes{splitter.split(param2), pairwiseArgs.second};
-
-    // Do the same thing for arguments, except all argument components are
-    // split into the same set. e.g., foo(bar.baz(), 0) may split the first
-    // argument into the set [bar, baz]. Verify there is at least one usable
-    // morpheme for each argument.
+  for (size_t pos = 0; pos < argCount; ++pos) {
+    ArgumentMorphemes& entry = table.Args[pos];
+
+    // All argument components are split into the same set. e.g.,
+    // foo(bar.baz(), 0) may split the first argument into the set [bar, baz].
+    // Verify there is at least one usable morpheme for each argument.
     // FIXME: Currently, the first argument will not produce any morphemes
     // because we've not decided to stick with this approach. If we continue
     // to produce only one identifier per argument, consider flattening the
     // interface of how we represent arguments.
-    auto morphemeCollector = [&args, &splitter](MorphemeSet& m, size_t pos) {
-      m.Position = pos;
-      for (const auto& arg : args[pos]) {
-        const auto& morphs = splitter.split(arg);
-        m.Morphemes.insert(morphs.begin(), morphs.end());
+    entry.Arg.Position = pos;
+    entry.Arg.Morphemes.clear();
+    for (const auto& arg : args[pos]) {
+      for (MorphemeInterner::Id morph : Splitter.split(arg, Morphemes))
+        entry.Arg.Morphemes.insert(morph);
+    }
+    // Remove any low quality morphemes from the arguments and note if this
+    // leaves us with no usable morphemes.
+    entry.Usable = !removeLowQualityMorphemes(entry.Arg.Morphemes);
+    entry.Signature = entry.Arg.Morphemes.signature();
+  }
+}
+
+std::shared_ptr<const Checker::DeclMorphemes>
+Checker::getDeclMorphemes(const CallDeclDescriptor& decl) {
+  // The key needs to distinguish a declaration without parameter names from
+  // one with an empty list of them.
+  std::string key = decl.fullyQualifiedName;
+  if (decl.paramNames) {
+    for (const std::string& param : *decl.paramNames) {
+      key += '\0';
+      key += param;
+    }
+  } else {
+    key += '\1';
+  }
+
+  if (Opts.DeclCacheCapacity) {
+    std::lock_guard<std::mutex> guard(DeclCacheLock);
+    auto iter = DeclCache.find(key);
+    if (iter != DeclCache.end()) {
+      ++CachedDeclarationLookups;
+      return iter->second;
+    }
+  }
+
+  auto ret = std::make_shared<DeclMorphemes>();
+  if (decl.paramNames) {
+    const std::vector<std::string>& params = *decl.paramNames;
+    ret->Params.resize(params.size());
+    for (size_t pos = 0; pos < params.size(); ++pos) {
+      // If there is a parameter for an argument, we may be able to run the
+      // cover-based checker, but only if the parameter has a name. Consider:
+      // void foo(int i, int, int, int j); foo(1, 2, 3, 4);
+      // as an example of when an argument may not have a corresponding named
+      // parameter.
+      DeclMorphemes::Param& param = ret->Params[pos];
+      param.Named = !params[pos].empty();
+      if (!param.Named)
+        continue;
+      // Having split the parameter identifier into morphemes, remove any
+      // morphemes that are low quality and note if there are no usable
+      // morphemes left. Consider: void foo(int i, int j); as an example of
+      // when a morpheme may be of sufficiently low quality to warrant ignoring
+      // it.
+      param.Morphemes = Splitter.split(params[pos], Morphemes);
+      param.Usable = !removeLowQualityMorphemes(param.Morphemes);
+    }
+
+    ret->UniqueMorphemes.resize(params.size() * params.size());
+    ret->UniqueSignatures.resize(params.size() * params.size());
+    for (size_t pos = 0; pos < params.size(); ++pos) {
+      for (size_t other = 0; other < params.size(); ++other) {
+        const DeclMorphemes::Param &one = ret->Params[pos],
+                                   &two = ret->Params[other];
+        if (pos != other && one.Usable && two.Usable) {
+          size_t idx = pos * params.size() + other;
+          ret->UniqueMorphemes[idx] =
+              nonLowEntropyDifference(one.Morphemes, two.Morphemes);
+          ret->UniqueSignatures[idx] = ret->UniqueMorphemes[idx].signature();
+        }
       }
-    };
+    }
+  }
+  ++DeclarationLookups;
+
+  if (Opts.DeclCacheCapacity) {
+    std::lock_guard<std::mutex> guard(DeclCacheLock);
+    // Rather than tracking how recently each declaration was used, start over
+    // once the cache fills up.
+    if (DeclCache.size() >= Opts.DeclCacheCapacity)
+      DeclCache.clear();
+    DeclCache.try_emplace(std::move(key), ret);
+  }
+  return ret;
+}
 
-    MorphemeSet arg1Morphemes, arg2Morphemes;
-    morphemeCollector(arg1Morphemes, pairwiseArgs.first);
-    morphemeCollector(arg2Morphemes, pairwiseArgs.second);
+float Checker::siteMatch(const DeclMorphemes& decl, SiteMorphemes& table,
+                         size_t arg, size_t param, Bias bias) {
+  assert(table.Args[arg].Usable && decl.param(param) &&
+         decl.param(param)->Usable && "Expected a usable argument and param");
+  MorphemeMatch& m = table.Matches[arg * table.Args.size() + param];
+  float& value = bias == Bias::Optimistic ? m.Optimistic : m.Pessimistic;
+  if (value < 0.0f) {
+    value = morphemesMatch(table.Args[arg].Arg.Morphemes,
+                           decl.param(param)->Morphemes, bias);
+    ++SiteMatches;
+  }
+  return value;
+}
 
-    // Similar to parameters, remove any low quality morphemes from the
-    // arguments and bail out if this leaves us with no usable morphemes.
-    if (removeLowQualityMorphemes(arg1Morphemes.Morphemes) ||
-        removeLowQualityMorphemes(arg2Morphemes.Morphemes))
+// Finds the assignment of rows to columns which maximizes the total weight of
+// the square matrix, using the Hungarian algorithm. Returns the column
+// assigned to each row.
+static std::vector<size_t>
+maximumWeightAssignment(const std::vector<std::vector<float>>& weights) {
+  // This is the O(n^3) formulation of the algorithm which maintains potentials
+  // for the rows and columns, minimizing the negated weights. Rows and columns
+  // are one-based internally; column 0 is a sentinel.
+  size_t n = weights.size();
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> rowPotential(n + 1, 0.0f), colPotential(n + 1, 0.0f);
+  std::vector<size_t> colMatch(n + 1, 0), way(n + 1, 0);
+  for (size_t row = 1; row <= n; ++row) {
+    colMatch[0] = row;
+    size_t col = 0;
+    std::vector<float> minSlack(n + 1, inf);
+    std::vector<bool> used(n + 1, false);
+    do {
+      used[col] = true;
+      size_t curRow = colMatch[col], nextCol = 0;
+      float delta = inf;
+      for (size_t c = 1; c <= n; ++c) {
+        if (used[c])
+          continue;
+        float slack = -weights[curRow - 1][c - 1] - rowPotential[curRow] -
+                      colPotential[c];
+        if (slack < minSlack[c]) {
+          minSlack[c] = slack;
+          way[c] = col;
+        }
+        if (minSlack[c] < delta) {
+          delta = minSlack[c];
+          nextCol = c;
+        }
+      }
+      for (size_t c = 0; c <= n; ++c) {
+        if (used[c]) {
+          rowPotential[colMatch[c]] += delta;
+          colPotential[c] -= delta;
+        } else {
+          minSlack[c] -= delta;
+        }
+      }
+      col = nextCol;
+    } while (colMatch[col] != 0);
+    do {
+      size_t prevCol = way[col];
+      colMatch[col] = colMatch[prevCol];
+      col = prevCol;
+    } while (col != 0);
+  }
+
+  std::vector<size_t> ret(n);
+  for (size_t col = 1; col <= n; ++col)
+    ret[colMatch[col] - 1] = col - 1;
+  return ret;
+}
+
+bool Checker::checkForRotations(const DeclMorphemes& decl,
+                                SiteMorphemes& table, ResultSink sink) {
+  // Only positions with both a usable argument and a usable parameter can take
+  // part in a rotation.
+  std::vector<size_t> positions;
+  for (size_t pos = 0; pos < table.Args.size(); ++pos) {
+    const DeclMorphemes::Param* param = decl.param(pos);
+    if (table.Args[pos].Usable && param && param->Usable)
+      positions.push_back(pos);
+  }
+  if (positions.size() < 3)
+    return true;
+
+  // Weigh each assignment of an argument to a parameter by how well the
+  // argument covers the parameter. Leaving an argument where it is gets a
+  // slight edge so that ties are not reported as rotations.
+  std::vector<std::vector<float>> weights(
+      positions.size(), std::vector<float>(positions.size()));
+  for (size_t row = 0; row < positions.size(); ++row) {
+    for (size_t col = 0; col < positions.size(); ++col) {
+      weights[row][col] = siteMatch(decl, table, positions[row],
+                                    positions[col], Bias::Pessimistic) +
+                          (row == col ? 0.001f : 0.0f);
+    }
+  }
+  std::vector<size_t> assignment = maximumWeightAssignment(weights);
+
+  // Report each cycle of three or more arguments in the assignment; the
+  // pairwise check already handles two arguments swapping places.
+  std::vector<bool> visited(positions.size(), false);
+  for (size_t start = 0; start < positions.size(); ++start) {
+    std::vector<size_t> cycle;
+    for (size_t idx = start; !visited[idx]; idx = assignment[idx]) {
+      visited[idx] = true;
+      cycle.push_back(idx);
+    }
+    if (cycle.size() < 3)
+      continue;
+
+    // Every argument in the rotation has to match badly where it is and well
+    // where it belongs, just like with a pairwise swap.
+    std::optional<float> score;
+    for (size_t idx : cycle) {
+      size_t pos = positions[idx], belongsAt = positions[assignment[idx]];
+      float existing = siteMatch(decl, table, pos, pos, Bias::Optimistic),
+            swapped =
+                siteMatch(decl, table, pos, belongsAt, Bias::Pessimistic);
+      if (existing > Opts.ExistingMorphemeMatchMax ||
+          swapped < Opts.SwappedMorphemeMatchMin) {
+        score.reset();
+        break;
+      }
+      float psi = swapped / (existing + 0.01f);
+      score = std::min(score.value_or(psi), psi);
+    }
+    if (!score)
       continue;
 
-    if (!param1.empty() && !param2.empty()) {
-      // Having split the parameter identifiers into morphemes, remove any
-      // morphemes that are low quality and bail out if there are no usable
-      // morphemes left for either parameter. Consider: void foo(int i, int j);
-      // as an example of when a morpheme may be of sufficiently low quality to
-      // warrant ignoring it.
-      if (removeLowQualityMorphemes(param1Morphemes.Morphemes) ||
-          removeLowQualityMorphemes(param2Morphemes.Morphemes))
+    std::vector<size_t> rotation;
+    for (size_t idx : cycle)
+      rotation.push_back(positions[idx] + 1);
+    size_t arg1 = rotation[0], arg2 = rotation[1];
+    if (!sink(Result{
+            arg1, arg2,
+            morphemeList(table.Args[positions[cycle[0]]].Arg.Morphemes),
+            morphemeList(table.Args[positions[cycle[1]]].Arg.Morphemes),
+            ParameterNameRotationBasedScoreCard(*score, std::move(rotation))}))
+      return false;
+  }
+  return true;
+}
+
+// Returns a sink which collects every result into the given vector.
+static auto appendTo(std::vector<Result>& results) {
+  return [&results](Result&& result) {
+    results.push_back(std::move(result));
+    return true;
+  };
+}
+
+std::vector<Result> Checker::CheckSite(const CallSite& site, Check whichCheck) {
+  SiteMorphemes table;
+  std::vector<Result> results;
+  checkSite(site, whichCheck, table, appendTo(results));
+  return results;
+}
+
+size_t Checker::CheckSite(const CallSite& site, ResultSink sink,
+                          Check whichCheck, float minScore) {
+  SiteMorphemes table;
+  size_t count = 0;
+  checkSite(site, whichCheck, table, [&](Result&& result) {
+    if (result.score.score() < minScore)
+      return true;
+    ++count;
+    return sink(std::move(result));
+  });
+  return count;
+}
+
+namespace {
+// The call sites still waiting to be checked by one of the threads of a
+// CheckSites() call. The owning thread takes sites from the front, and idle
+// threads steal the back half once their own range is exhausted.
+struct SiteRange {
+  std::mutex Lock;
+  size_t Begin = 0, End = 0;
+
+  std::optional<size_t> takeFront() {
+    std::lock_guard<std::mutex> guard(Lock);
+    if (Begin == End)
+      return std::nullopt;
+    return Begin++;
+  }
+
+  // Removes the back half of the remaining sites, rounding up, and returns
+  // them as a [begin, end) pair. Returns nullopt if there are none left.
+  std::optional<std::pair<size_t, size_t>> stealBack() {
+    std::lock_guard<std::mutex> guard(Lock);
+    if (Begin == End)
+      return std::nullopt;
+    size_t oldEnd = End;
+    End -= (End - Begin + 1) / 2;
+    return std::make_pair(End, oldEnd);
+  }
+
+  void reset(size_t begin, size_t end) {
+    std::lock_guard<std::mutex> guard(Lock);
+    Begin = begin;
+    End = end;
+  }
+};
+} // namespace
+
+std::vector<std::vector<Result>> Checker::CheckSites(const CallSite* sites,
+                                                     size_t count,
+                                                     unsigned threads,
+                                                     Check whichCheck) {
+  std::vector<std::vector<Result>> results(count);
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+
+  // Each result goes into its own slot, so the output does not depend on which
+  // thread checked which site.
+  if (threads <= 1) {
+    SiteMorphemes table;
+    for (size_t idx = 0; idx < count; ++idx)
+      checkSite(sites[idx], whichCheck, table, appendTo(results[idx]));
+    return results;
+  }
+
+  // Start each thread out with an equal, contiguous share of the sites so that
+  // neighboring sites, which tend to share callees, are checked together.
+  std::vector<SiteRange> ranges(threads);
+  for (unsigned idx = 0; idx < threads; ++idx)
+    ranges[idx].reset(count * idx / threads, count * (idx + 1) / threads);
+
+  auto worker = [&](unsigned self) {
+    SiteMorphemes table;
+    while (true) {
+      while (std::optional<size_t> idx = ranges[self].takeFront())
+        checkSite(sites[*idx], whichCheck, table, appendTo(results[*idx]));
+
+      // Out of work, so steal from the other threads, starting with the next
+      // one along. If they are all out of work too, this thread is done.
+      std::optional<std::pair<size_t, size_t>> stolen;
+      for (unsigned offset = 1; offset < threads && !stolen; ++offset)
+        stolen = ranges[(self + offset) % threads].stealBack();
+      if (!stolen)
+        return;
+      ranges[self].reset(stolen->first, stolen->second);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned idx = 1; idx < threads; ++idx)
+    pool.emplace_back(worker, idx);
+  worker(0);
+  for (std::thread& thread : pool)
+    thread.join();
+  return results;
+}
+
+bool Checker::checkSite(const CallSite& site, Check whichCheck,
+                        SiteMorphemes& table, ResultSink sink) {
+  // If there aren't at least two arguments to the call, there's no swapping
+  // possible, so bail out early.
+  const std::vector<CallSite::ArgumentNames>& args = site.positionalArgNames;
+  if (args.size() < 2)
+    return true;
+
+  // Arguments past the end of the declaration's parameter list are variadic.
+  // Only the first few of them are checked if the configuration says so, which
+  // keeps calls to printf-style functions with many arguments cheap.
+  size_t argCount = args.size();
+  if (Opts.MaxVariadicArguments && site.callDecl.paramNames) {
+    size_t paramCount = site.callDecl.paramNames->size();
+    if (argCount > paramCount &&
+        argCount - paramCount > *Opts.MaxVariadicArguments)
+      argCount = paramCount + *Opts.MaxVariadicArguments;
+    if (argCount < 2)
+      return true;
+  }
+
+  // If there is a statistics model, fetch everything it knows about the callee
+  // at the argument positions for this call in one go, but only once a check
+  // actually needs it. Callees which the model does not have are treated as
+  // though there were no statistics model.
+  std::shared_ptr<const CalleeStatistics> calleeStats;
+  bool calleeStatsFetched = false;
+  auto getCalleeStats = [&]() -> const CalleeStatistics* {
+    if (!calleeStatsFetched) {
+      calleeStats =
+          getCalleeStatistics(site.callDecl.fullyQualifiedName, argCount);
+      calleeStatsFetched = true;
+    }
+    return calleeStats.get();
+  };
+
+  // Split every argument once, up front, rather than once for each pair it is
+  // a part of. The parameters only depend on the declaration, so they are
+  // split once for each declaration.
+  splitSite(site, argCount, table);
+  std::shared_ptr<const DeclMorphemes> decl = getDeclMorphemes(site.callDecl);
+  bool checkCovers =
+      whichCheck == Check::All || whichCheck == Check::CoverBased;
+  if (checkCovers)
+    table.Matches.assign(argCount * argCount, MorphemeMatch());
+
+  // Walk through each combination of argument pairs from the call site.
+  for (const auto& pairwiseArgs : PairwiseCombinations(argCount)) {
+    const ArgumentMorphemes &arg1 = table.Args[pairwiseArgs.first],
+                            &arg2 = table.Args[pairwiseArgs.second];
+
+    // Bail out if either argument has no usable morphemes.
+    if (!arg1.Usable || !arg2.Usable)
+      continue;
+
+    // If there is a corresponding named parameter for each argument, we may be
+    // able to run the cover-based checker. Consider:
+    // void foo(int i, ...); foo(1, 2, 3, 4);
+    // as an example of when an argument may not have a corresponding parameter.
+    const DeclMorphemes::Param *param1 = decl->param(pairwiseArgs.first),
+                               *param2 = decl->param(pairwiseArgs.second);
+    if (param1 && param1->Named && param2 && param2->Named) {
+      // Bail out if there are no usable morphemes left for either parameter.
+      if (!param1->Usable || !param2->Usable)
         continue;
 
       // Run the cover-based checker first.
-      if (whichCheck == Check::All || whichCheck == Check::CoverBased) {
+      if (checkCovers) {
         if (std::optional<Result> coverWarning = checkForCoverBasedSwap(
-                std::make_pair(param1Morphemes, param2Morphemes),
-                std::make_pair(arg1Morphemes, arg2Morphemes), site)) {
-          results.push_back(std::move(*coverWarning));
+                *decl, table, {arg1.Arg, arg2.Arg}, site, getCalleeStats())) {
+          if (!sink(std::move(*coverWarning)))
+            return false;
           continue;
         }
       }
     }
 
     // If that didn't find anything, run the statistics-based checker.
-    if ((whichCheck == Check::All || whichCheck == Check::StatsBased) &&
-        Stats) {
-      assert(Stats->valid() && "Expected valid statistics by this point");
-
-      if (std::optional<Result> statsWarning = checkForStatisticsBasedSwap(
-              std::make_pair(param1Morphemes, param2Morphemes),
-              std::make_pair(arg1Morphemes, arg2Morphemes), site)) {
-        results.push_back(std::move(*statsWarning));
+    if (whichCheck == Check::All || whichCheck == Check::StatsBased) {
+      if (const CalleeStatistics* stats = getCalleeStats()) {
+        assert(Stats->valid() && "Expected valid statistics by this point");
+
+        if (std::optional<Result> statsWarning = checkForStatisticsBasedSwap(
+                {arg1.Arg, arg2.Arg}, *stats)) {
+          if (!sink(std::move(*statsWarning)))
+            return false;
+        }
       }
     }
   }
 
-  return results;
+  if (checkCovers && Opts.DetectRotations)
+    return checkForRotations(*decl, table, sink);
+  return true;
+}
+
+bool Checker::mayHaveStatistics(std::string_view funcName) const {
+  return Stats && Stats->mayHaveStatistics(funcName);
+}
+
+CheckerCounters Checker::counters() const {
+  CheckerCounters ret;
+  ret.CalleeLookups = CalleeLookups;
+  ret.EmptyCalleeLookups = EmptyCalleeLookups;
+  ret.SkippedCalleeLookups = SkippedCalleeLookups;
+  ret.CachedCalleeLookups = CachedCalleeLookups;
+  ret.DeclarationLookups = DeclarationLookups;
+  ret.CachedDeclarationLookups = CachedDeclarationLookups;
+  ret.IdentifierMemoHits = Splitter.memoHits();
+  ret.IdentifierMemoMisses = Splitter.memoMisses();
+  ret.CoverPairs = CoverPairs;
+  ret.PrunedCoverPairs = PrunedCoverPairs;
+  ret.SiteMatches = SiteMatches;
+  return ret;
 }
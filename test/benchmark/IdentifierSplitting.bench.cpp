@@ -0,0 +1,109 @@
+//===- IdentifierSplitting.bench.cpp ----------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+
+// Compares the speed of the scalar and ASCII identifier splitters.
+//
+// Usage: BenchmarkIdentifierSplitting [<iterations>]
+
+#include "IdentifierSplitting.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace swapped_arg;
+
+// Makes identifiers in a mix of styles from a handful of common morphemes.
+static std::vector<std::string> makeIdentifiers(size_t count) {
+  static const char* Words[] = {"src",   "dst",    "buffer", "length", "count",
+                                "width", "height", "index",  "offset", "x",
+                                "y",     "alpha",  "node",   "parent", "ctx"};
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<size_t> word(0, std::size(Words) - 1),
+      wordCount(1, 4), style(0, 2);
+
+  std::vector<std::string> ret;
+  for (size_t idx = 0; idx < count; ++idx) {
+    std::string ident;
+    size_t words = wordCount(gen), identStyle = style(gen);
+    for (size_t w = 0; w < words; ++w) {
+      std::string part = Words[word(gen)];
+      if (identStyle == 0 && w != 0) {
+        // camelCase
+        part[0] = static_cast<char>(part[0] - 'a' + 'A');
+      } else if (identStyle == 1 && w != 0) {
+        // snake_case
+        part.insert(part.begin(), '_');
+      } else if (identStyle == 2) {
+        // UPPER_CASE
+        for (char& c : part)
+          c = static_cast<char>(c - 'a' + 'A');
+        if (w != 0)
+          part.insert(part.begin(), '_');
+      }
+      ident += part;
+    }
+    ret.push_back(std::move(ident));
+  }
+  return ret;
+}
+
+using SplitFn = void (*)(const std::string&,
+                         const std::function<void(std::string_view)>&);
+
+// Returns the average number of nanoseconds taken to split each identifier.
+static double timeSplits(const std::vector<std::string>& idents,
+                         size_t iterations, SplitFn split) {
+  // Sum the word lengths so that the splitting cannot be optimized away.
+  size_t total = 0;
+  std::function<void(std::string_view)> collect =
+      [&total](std::string_view word) { total += word.size(); };
+  auto start = std::chrono::steady_clock::now();
+  for (size_t iter = 0; iter < iterations; ++iter)
+    for (const std::string& ident : idents)
+      split(ident, collect);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  if (total == 0)
+    std::cerr << "warning: no words were split\n";
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         (iterations * idents.size());
+}
+
+int main(int argc, char* argv[]) {
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+  if (iterations == 0) {
+    std::cout << "[<iterations>]\n";
+    return EXIT_FAILURE;
+  }
+  std::vector<std::string> idents = makeIdentifiers(10000);
+
+  double scalar = timeSplits(idents, iterations, test::forEachWordScalar);
+  double ascii = timeSplits(
+      idents, iterations,
+      [](const std::string& ident,
+         const std::function<void(std::string_view)>& fn) {
+        test::forEachWordAscii(ident, fn);
+      });
+
+  std::cout << "scalar: " << scalar << " ns/identifier\n"
+            << "ascii:  " << ascii << " ns/identifier\n"
+            << "speedup: " << scalar / ascii << "x\n";
+  return EXIT_SUCCESS;
+}
@@ -15,9 +15,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "SwappedArgChecker.hpp"
+#include "StatisticsModel.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include <cstdio>
+#include <thread>
 
 using namespace swapped_arg;
 
@@ -25,9 +27,14 @@ class WithStatsDatabase {
   CheckerConfiguration Config;
 
 public:
+  enum class Schema { Flat, Normalized };
+
   // Tuple order is {function, argPos, morpheme, weight}
-  explicit WithStatsDatabase(std::initializer_list<test::StatsDBRow> rows) {
-    Config.ModelPath = test::createStatsDB(rows);
+  explicit WithStatsDatabase(std::initializer_list<test::StatsDBRow> rows,
+                             Schema schema = Schema::Flat) {
+    Config.ModelPath = schema == Schema::Flat
+                           ? test::createStatsDB(rows)
+                           : test::createNormalizedStatsDB(rows);
   }
   ~WithStatsDatabase() {
     if (!Config.ModelPath.empty()) {
@@ -200,6 +207,46 @@ TEST(AllSwapping, ShouldNotMatch) {
   EXPECT_EQ(Results.size(), 0);
 }
 
+TEST(CoverSwapping, Rotations) {
+  CheckerConfiguration Config;
+  Config.DetectRotations = true;
+  Checker C(Config);
+
+  // Each argument belongs at the next position, and the last at the first.
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "RotationTest";
+  Site.callDecl.paramNames = {"red", "green", "blue"};
+  Site.positionalArgNames = {{"blue"}, {"red"}, {"green"}};
+
+  std::vector<Result> Results = C.CheckSite(Site, Checker::Check::CoverBased);
+  ASSERT_EQ(Results.size(), 1);
+  EXPECT_EQ(Results[0].arg1, 1);
+  EXPECT_EQ(Results[0].arg2, 3);
+  EXPECT_THAT(Results[0].morphemes1, testing::ElementsAre("blue"));
+  EXPECT_THAT(Results[0].morphemes2, testing::ElementsAre("green"));
+  ASSERT_EQ(Results[0].score.kind(), ScoreCard::ParameterNameRotationBased);
+  const auto* Card =
+      Results[0].score.getAs<ParameterNameRotationBasedScoreCard>();
+  ASSERT_NE(Card, nullptr);
+  EXPECT_THAT(Card->rotation(), testing::ElementsAre(1, 3, 2));
+
+  // Rotations are only reported when asked for.
+  Checker Default;
+  EXPECT_EQ(Default.CheckSite(Site, Checker::Check::CoverBased).size(), 0);
+
+  // A rotation whose morphemes are not fully covered is not reported.
+  CallSite Uncovered;
+  Uncovered.callDecl.fullyQualifiedName = "UncoverdMorphemeRotation";
+  Uncovered.callDecl.paramNames = {"barking_dogs", "hissing_cats",
+                                   "running_alligators",
+                                   "flailing_nudibranches"};
+  Uncovered.positionalArgNames = {{"barfing_nudibranches"},
+                                  {"dogs_lolling"},
+                                  {"purring_cats"},
+                                  {"alligators_eating"}};
+  EXPECT_EQ(C.CheckSite(Uncovered, Checker::Check::All).size(), 0);
+}
+
 TEST(CoverSwapping, MultipleMorphemes) {
   Checker C;
 
@@ -218,6 +265,102 @@ TEST(CoverSwapping, MultipleMorphemes) {
               testing::UnorderedElementsAre("dogs", "lolling"));
 }
 
+TEST(CoverSwapping, ManyArguments) {
+  Checker C;
+
+  // Only the swapped pair should be reported, even when some of the other
+  // positions lack a named parameter.
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "ManyArgumentsTest";
+  Site.callDecl.paramNames = {"red", "green", "blue",  "alpha",  "x",
+                              "y",   "",      "width", "height", "depth"};
+  Site.positionalArgNames = {{"red"}, {"green"},  {"blue"},  {"alpha"},
+                             {"x"},   {"y"},      {"z"},     {"height"},
+                             {"width"}, {"depth"}};
+
+  std::vector<Result> Results = C.CheckSite(Site, Checker::Check::CoverBased);
+  ASSERT_EQ(Results.size(), 1);
+  EXPECT_EQ(Results[0].arg1, 8);
+  EXPECT_EQ(Results[0].arg2, 9);
+  EXPECT_THAT(Results[0].morphemes1, testing::UnorderedElementsAre("height"));
+  EXPECT_THAT(Results[0].morphemes2, testing::UnorderedElementsAre("width"));
+
+  // Most pairs should be rejected from their signatures alone. Unrelated
+  // morphemes can share a signature bit, so this only bounds how many pairs
+  // get past the signatures; the swapped pair always does.
+  CheckerCounters Counters = C.counters();
+  ASSERT_GT(Counters.CoverPairs, Counters.PrunedCoverPairs);
+  size_t Scored = Counters.CoverPairs - Counters.PrunedCoverPairs;
+  EXPECT_LE(Scored * 4, Counters.CoverPairs);
+  // Arguments are only matched against parameters for the pairs which are
+  // scored, at most four times for each, rather than all against all.
+  EXPECT_LE(Counters.SiteMatches, Scored * 4);
+}
+
+TEST(CoverSwapping, ResultSink) {
+  Checker C;
+
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "ResultSinkTest";
+  Site.callDecl.paramNames = {"red", "green", "width", "height"};
+  Site.positionalArgNames = {{"green"}, {"red"}, {"height"}, {"width"}};
+
+  // Every swap is handed to the sink, in the same order as they are returned.
+  std::vector<std::pair<size_t, size_t>> Found;
+  size_t Count = C.CheckSite(Site, [&](Result&& R) {
+    Found.emplace_back(R.arg1, R.arg2);
+    return true;
+  });
+  EXPECT_EQ(Count, 2);
+  EXPECT_THAT(Found, testing::ElementsAre(std::make_pair(1, 2),
+                                          std::make_pair(3, 4)));
+  EXPECT_EQ(C.CheckSite(Site).size(), 2);
+
+  // Checking stops once the sink asks it to.
+  Found.clear();
+  Count = C.CheckSite(Site, [&](const Result& R) {
+    Found.emplace_back(R.arg1, R.arg2);
+    return false;
+  });
+  EXPECT_EQ(Count, 1);
+  EXPECT_THAT(Found, testing::ElementsAre(std::make_pair(1, 2)));
+
+  // Swaps scoring below the minimum never reach the sink.
+  Count = C.CheckSite(
+      Site, [](const Result&) { return true; }, Checker::Check::All, 1000.0f);
+  EXPECT_EQ(Count, 0);
+}
+
+TEST(CoverSwapping, RepeatedIdentifiers) {
+  Checker C;
+
+  // Identifiers which were already split at an earlier call site should not
+  // be split again.
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "RepeatedIdentifiersTest";
+  Site.callDecl.paramNames = {"cats", "dogs"};
+  Site.positionalArgNames = {{"dogs"}, {"cats"}};
+
+  EXPECT_EQ(C.CheckSite(Site, Checker::Check::CoverBased).size(), 1);
+  EXPECT_EQ(C.counters().IdentifierMemoMisses, 2);
+  EXPECT_EQ(C.counters().DeclarationLookups, 1);
+  EXPECT_EQ(C.CheckSite(Site, Checker::Check::CoverBased).size(), 1);
+  EXPECT_EQ(C.counters().IdentifierMemoMisses, 2);
+  // The parameters are not split again for the same declaration.
+  EXPECT_EQ(C.counters().IdentifierMemoHits, 4);
+  EXPECT_EQ(C.counters().DeclarationLookups, 1);
+  EXPECT_EQ(C.counters().CachedDeclarationLookups, 1);
+
+  // Different parameter names for the same callee are a different
+  // declaration, such as one from another translation unit.
+  Site.callDecl.paramNames = {"horses", "cows"};
+  EXPECT_TRUE(C.CheckSite(Site, Checker::Check::CoverBased).empty());
+  EXPECT_EQ(C.counters().DeclarationLookups, 2);
+  Site.callDecl.paramNames.reset();
+  EXPECT_TRUE(C.CheckSite(Site, Checker::Check::CoverBased).empty());
+  EXPECT_EQ(C.counters().DeclarationLookups, 3);
+}
+
 TEST(CoverSwapping, NumericSuffixes) {
   Checker C;
 
@@ -282,3 +425,334 @@ TEST(CoverSwapping, WithStats) {
   EXPECT_EQ(Results.size(), 0);
 }
 
+TEST(StatsSwapping, InMemoryModel) {
+  // The in-memory model should produce the same results as querying the
+  // database directly.
+  WithStatsDatabase DB({{"InMemoryTest", 0, "cats", 1.0f},
+                        {"InMemoryTest", 1, "dogs", 1.0f},
+                        {"InMemoryVettingTest", 0, "dogs", 1.0f},
+                        {"InMemoryVettingTest", 1, "cats", 1.0f}});
+  CheckerConfiguration Config = DB;
+  Config.LoadModelInMemory = true;
+  Checker C(Config);
+
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "InMemoryTest";
+  Site.positionalArgNames = {{"dogs"}, {"cats"}};
+
+  std::vector<Result> Results = C.CheckSite(Site, Checker::Check::StatsBased);
+  EXPECT_EQ(Results.size(), 1);
+  EXPECT_EQ(Results[0].arg1, 1);
+  EXPECT_EQ(Results[0].arg2, 2);
+  EXPECT_THAT(Results[0].morphemes1, testing::UnorderedElementsAre("dogs"));
+  EXPECT_THAT(Results[0].morphemes2, testing::UnorderedElementsAre("cats"));
+
+  Site.positionalArgNames = {{"cats"}, {"dogs"}};
+  Results = C.CheckSite(Site, Checker::Check::All);
+  EXPECT_TRUE(Results.empty());
+
+  // Functions which are not in the model should not be considered.
+  Site.callDecl.fullyQualifiedName = "NotInTheModel";
+  Site.positionalArgNames = {{"dogs"}, {"cats"}};
+  Results = C.CheckSite(Site, Checker::Check::StatsBased);
+  EXPECT_TRUE(Results.empty());
+
+  // Cover-based swaps should still be vetted by the in-memory statistics.
+  Site.callDecl.fullyQualifiedName = "InMemoryVettingTest";
+  Site.callDecl.paramNames = {"cats", "dogs"};
+  Results = C.CheckSite(Site, Checker::Check::CoverBased);
+  EXPECT_TRUE(Results.empty());
+}
+
+TEST(StatsSwapping, BinaryModel) {
+  // A binary model converted from the SQLite model should be picked up based
+  // on its file header and should produce the same results.
+  WithStatsDatabase DB({{"BinaryTest", 0, "cats", 1.0f},
+                        {"BinaryTest", 1, "dogs", 1.0f},
+                        {"BinaryTest", 1, "horses", 0.5f},
+                        {"BinaryVettingTest", 0, "dogs", 1.0f},
+                        {"BinaryVettingTest", 1, "cats", 1.0f}});
+  CheckerConfiguration Config = DB;
+  std::string SQLitePath = Config.ModelPath, Error;
+  Config.ModelPath += ".model";
+  ASSERT_TRUE(model::convertToBinary(SQLitePath, Config.ModelPath, Error))
+      << Error;
+
+  {
+    Checker C(Config);
+
+    CallSite Site;
+    Site.callDecl.fullyQualifiedName = "BinaryTest";
+    Site.positionalArgNames = {{"dogs"}, {"cats"}};
+
+    std::vector<Result> Results = C.CheckSite(Site, Checker::Check::StatsBased);
+    EXPECT_EQ(Results.size(), 1);
+    EXPECT_EQ(Results[0].arg1, 1);
+    EXPECT_EQ(Results[0].arg2, 2);
+    EXPECT_THAT(Results[0].morphemes1, testing::UnorderedElementsAre("dogs"));
+    EXPECT_THAT(Results[0].morphemes2, testing::UnorderedElementsAre("cats"));
+
+    Site.positionalArgNames = {{"cats"}, {"dogs"}};
+    Results = C.CheckSite(Site, Checker::Check::All);
+    EXPECT_TRUE(Results.empty());
+
+    Site.callDecl.fullyQualifiedName = "BinaryVettingTest";
+    Site.callDecl.paramNames = {"cats", "dogs"};
+    Site.positionalArgNames = {{"dogs"}, {"cats"}};
+    Results = C.CheckSite(Site, Checker::Check::CoverBased);
+    EXPECT_TRUE(Results.empty());
+  }
+
+  ::remove(Config.ModelPath.c_str());
+}
+
+TEST(StatsSwapping, NormalizedModel) {
+  // Models using the normalized schema are queried by string ID rather than
+  // through the weights view, and should behave the same before and after the
+  // model has been optimized.
+  WithStatsDatabase DB({{"NormalizedTest", 0, "cats", 1.0f},
+                        {"NormalizedTest", 1, "dogs", 1.0f},
+                        {"NormalizedVettingTest", 0, "dogs", 1.0f},
+                        {"NormalizedVettingTest", 1, "cats", 1.0f}},
+                       WithStatsDatabase::Schema::Normalized);
+
+  auto runChecks = [](const CheckerConfiguration& Config) {
+    Checker C(Config);
+
+    CallSite Site;
+    Site.callDecl.fullyQualifiedName = "NormalizedTest";
+    Site.positionalArgNames = {{"dogs"}, {"cats"}};
+
+    std::vector<Result> Results = C.CheckSite(Site, Checker::Check::StatsBased);
+    EXPECT_EQ(Results.size(), 1);
+    EXPECT_EQ(Results[0].arg1, 1);
+    EXPECT_EQ(Results[0].arg2, 2);
+    EXPECT_THAT(Results[0].morphemes1, testing::UnorderedElementsAre("dogs"));
+    EXPECT_THAT(Results[0].morphemes2, testing::UnorderedElementsAre("cats"));
+
+    Site.callDecl.fullyQualifiedName = "NotInTheModel";
+    Results = C.CheckSite(Site, Checker::Check::StatsBased);
+    EXPECT_TRUE(Results.empty());
+
+    Site.callDecl.fullyQualifiedName = "NormalizedVettingTest";
+    Site.callDecl.paramNames = {"cats", "dogs"};
+    Results = C.CheckSite(Site, Checker::Check::CoverBased);
+    EXPECT_TRUE(Results.empty());
+  };
+
+  const CheckerConfiguration& Config = DB;
+  runChecks(Config);
+
+  std::string Error;
+  ASSERT_TRUE(model::optimize(Config.ModelPath, Error)) << Error;
+  runChecks(Config);
+
+  CheckerConfiguration InMemory = Config;
+  InMemory.LoadModelInMemory = true;
+  runChecks(InMemory);
+}
+
+TEST(StatsSwapping, ConcurrentChecks) {
+  // A single Checker should be usable from many threads at once.
+  WithStatsDatabase DB({{"ConcurrentTest", 0, "cats", 1.0f},
+                        {"ConcurrentTest", 1, "dogs", 1.0f}});
+  Checker C(DB);
+
+  CallSite Swapped, NotSwapped;
+  Swapped.callDecl.fullyQualifiedName = "ConcurrentTest";
+  Swapped.positionalArgNames = {{"dogs"}, {"cats"}};
+  NotSwapped.callDecl.fullyQualifiedName = "ConcurrentTest";
+  NotSwapped.positionalArgNames = {{"cats"}, {"dogs"}};
+
+  std::vector<std::thread> Threads;
+  std::vector<size_t> Mismatches(8, 0);
+  for (size_t Idx = 0; Idx < Mismatches.size(); ++Idx) {
+    Threads.emplace_back([&, Idx] {
+      for (int Iter = 0; Iter < 100; ++Iter) {
+        if (C.CheckSite(Swapped, Checker::Check::StatsBased).size() != 1)
+          ++Mismatches[Idx];
+        if (!C.CheckSite(NotSwapped, Checker::Check::StatsBased).empty())
+          ++Mismatches[Idx];
+      }
+    });
+  }
+  for (std::thread& T : Threads)
+    T.join();
+  EXPECT_THAT(Mismatches, testing::Each(0));
+}
+
+TEST(AllSwapping, BatchChecks) {
+  WithStatsDatabase DB({{"BatchTest", 0, "cats", 1.0f},
+                        {"BatchTest", 1, "dogs", 1.0f}});
+  Checker C(DB);
+
+  // Mix sites with stats-based swaps, cover-based swaps, and no swaps at all.
+  std::vector<CallSite> Sites(1000);
+  for (size_t Idx = 0; Idx < Sites.size(); ++Idx) {
+    CallSite& Site = Sites[Idx];
+    switch (Idx % 3) {
+    case 0:
+      Site.callDecl.fullyQualifiedName = "BatchTest";
+      Site.positionalArgNames = {{"dogs"}, {"cats"}};
+      break;
+    case 1:
+      Site.callDecl.fullyQualifiedName = "BatchCoverTest";
+      Site.callDecl.paramNames = {"barking_dogs", "hissing_cats",
+                                  "arg" + std::to_string(Idx)};
+      Site.positionalArgNames = {{"cats"}, {"dogs"}, {"other"}};
+      break;
+    default:
+      Site.callDecl.fullyQualifiedName = "BatchTest";
+      Site.positionalArgNames = {{"cats"}, {"dogs"}};
+      break;
+    }
+  }
+
+  // Every thread count gives the same results as checking one site at a time,
+  // in the same order as the sites.
+  for (unsigned Threads : {0u, 1u, 4u, 64u}) {
+    std::vector<std::vector<Result>> Results = C.CheckSites(Sites, Threads);
+    ASSERT_EQ(Results.size(), Sites.size());
+    for (size_t Idx = 0; Idx < Sites.size(); ++Idx) {
+      std::vector<Result> Expected = C.CheckSite(Sites[Idx]);
+      ASSERT_EQ(Results[Idx].size(), Expected.size());
+      for (size_t R = 0; R < Expected.size(); ++R) {
+        EXPECT_EQ(Results[Idx][R].arg1, Expected[R].arg1);
+        EXPECT_EQ(Results[Idx][R].arg2, Expected[R].arg2);
+        EXPECT_EQ(Results[Idx][R].score.kind(), Expected[R].score.kind());
+      }
+    }
+  }
+  EXPECT_TRUE(C.CheckSites(std::vector<CallSite>(), 4).empty());
+}
+
+TEST(StatsSwapping, SharedModel) {
+  // Checkers using the same model file should share a single loaded model,
+  // which is unloaded once the last of them is destroyed.
+  WithStatsDatabase DB({{"SharedTest", 0, "cats", 1.0f},
+                        {"SharedTest", 1, "dogs", 1.0f}});
+  size_t Baseline = test::loadedModelCount();
+
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "SharedTest";
+  Site.positionalArgNames = {{"dogs"}, {"cats"}};
+  {
+    Checker C1(DB), C2(DB);
+    EXPECT_EQ(test::loadedModelCount(), Baseline + 1);
+    EXPECT_EQ(C1.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+    EXPECT_EQ(C2.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+
+    // Loading the model into memory is a different way of loading it, so it
+    // is not shared with the Checkers querying the database.
+    CheckerConfiguration InMemory = DB;
+    InMemory.LoadModelInMemory = true;
+    Checker C3(InMemory);
+    EXPECT_EQ(test::loadedModelCount(), Baseline + 2);
+    EXPECT_EQ(C3.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  }
+  EXPECT_EQ(test::loadedModelCount(), Baseline);
+}
+
+TEST(StatsSwapping, UnknownCallees) {
+  // Callees which are not in the model should never be looked up, no matter
+  // how the model is stored.
+  WithStatsDatabase Flat({{"KnownTest", 0, "cats", 1.0f},
+                          {"KnownTest", 1, "dogs", 1.0f}}),
+      Normalized({{"KnownTest", 0, "cats", 1.0f},
+                  {"KnownTest", 1, "dogs", 1.0f}},
+                 WithStatsDatabase::Schema::Normalized);
+  CheckerConfiguration InMemory = Flat, Binary = Flat;
+  InMemory.LoadModelInMemory = true;
+  std::string Error;
+  Binary.ModelPath += ".model";
+  ASSERT_TRUE(
+      model::convertToBinary(InMemory.ModelPath, Binary.ModelPath, Error))
+      << Error;
+
+  for (const CheckerConfiguration& Config :
+       {static_cast<const CheckerConfiguration&>(Flat),
+        static_cast<const CheckerConfiguration&>(Normalized), InMemory,
+        Binary}) {
+    Checker C(Config);
+    EXPECT_FALSE(C.mayHaveStatistics("UnknownTest"));
+    EXPECT_TRUE(C.mayHaveStatistics("KnownTest"));
+
+    CallSite Site;
+    Site.callDecl.fullyQualifiedName = "UnknownTest";
+    Site.callDecl.paramNames = {"horses", "cows"};
+    Site.positionalArgNames = {{"dogs"}, {"cats"}};
+    EXPECT_TRUE(C.CheckSite(Site).empty());
+    EXPECT_EQ(C.counters().CalleeLookups, 0);
+    EXPECT_EQ(C.counters().SkippedCalleeLookups, 1);
+
+    Site.callDecl.fullyQualifiedName = "KnownTest";
+    EXPECT_EQ(C.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+    EXPECT_EQ(C.counters().CalleeLookups, 1);
+    EXPECT_EQ(C.counters().EmptyCalleeLookups, 0);
+    EXPECT_EQ(C.counters().SkippedCalleeLookups, 1);
+  }
+  ::remove(Binary.ModelPath.c_str());
+
+  // Without a model, nothing has statistics.
+  EXPECT_FALSE(Checker().mayHaveStatistics("KnownTest"));
+}
+
+TEST(StatsSwapping, CachedCallees) {
+  // Statistics for a callee should be fetched from the model once and then
+  // reused, unless a call site needs positions that were not fetched.
+  WithStatsDatabase DB({{"CachedTest", 0, "cats", 1.0f},
+                        {"CachedTest", 1, "dogs", 1.0f},
+                        {"CachedTest", 2, "horses", 1.0f}});
+  Checker C(DB);
+
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "CachedTest";
+  Site.positionalArgNames = {{"dogs"}, {"cats"}};
+  EXPECT_EQ(C.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  EXPECT_EQ(C.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  EXPECT_EQ(C.counters().CalleeLookups, 1);
+  EXPECT_EQ(C.counters().CachedCalleeLookups, 1);
+
+  Site.positionalArgNames = {{"cats"}, {"horses"}, {"dogs"}};
+  EXPECT_EQ(C.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  EXPECT_EQ(C.counters().CalleeLookups, 2);
+  Site.positionalArgNames = {{"dogs"}, {"cats"}};
+  EXPECT_EQ(C.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  EXPECT_EQ(C.counters().CalleeLookups, 2);
+  EXPECT_EQ(C.counters().CachedCalleeLookups, 2);
+
+  // With the cache disabled, every call site queries the model.
+  CheckerConfiguration Uncached = DB;
+  Uncached.CalleeCacheCapacity = 0;
+  Checker U(Uncached);
+  EXPECT_EQ(U.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  EXPECT_EQ(U.CheckSite(Site, Checker::Check::StatsBased).size(), 1);
+  EXPECT_EQ(U.counters().CalleeLookups, 2);
+  EXPECT_EQ(U.counters().CachedCalleeLookups, 0);
+}
+
+TEST(StatsSwapping, VariadicArguments) {
+  WithStatsDatabase DB({{"VariadicTest", 0, "format", 1.0f},
+                        {"VariadicTest", 1, "cats", 1.0f},
+                        {"VariadicTest", 2, "dogs", 1.0f}});
+
+  CallSite Site;
+  Site.callDecl.fullyQualifiedName = "VariadicTest";
+  Site.callDecl.paramNames = {"format"};
+  Site.positionalArgNames = {{"format"}, {"dogs"}, {"cats"}};
+
+  CheckerConfiguration Config = DB;
+  for (std::optional<size_t> Max : {std::optional<size_t>(), {2}, {5}}) {
+    Config.MaxVariadicArguments = Max;
+    Checker C(Config);
+    std::vector<Result> Results = C.CheckSite(Site, Checker::Check::StatsBased);
+    ASSERT_EQ(Results.size(), 1);
+    EXPECT_EQ(Results[0].arg1, 2);
+    EXPECT_EQ(Results[0].arg2, 3);
+  }
+
+  // Variadic arguments past the maximum are not checked.
+  Config.MaxVariadicArguments = 1;
+  Checker C(Config);
+  EXPECT_TRUE(C.CheckSite(Site, Checker::Check::StatsBased).empty());
+}
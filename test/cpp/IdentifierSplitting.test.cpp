@@ -16,6 +16,7 @@
 #include "IdentifierSplitting.hpp"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include <random>
 
 using namespace swapped_arg;
 
@@ -50,3 +51,76 @@ TEST(IdentifierSplitting, split) {
   EXPECT_THAT(Splitter.split("foo_bar_bar"),
               testing::UnorderedElementsAre("foo", "bar"));
 }
+
+TEST(IdentifierSplitting, asciiAgreesWithScalar) {
+  auto Words = [](bool Ascii, const std::string& Input) {
+    std::vector<std::string> Ret;
+    auto Collect = [&Ret](std::string_view Word) { Ret.emplace_back(Word); };
+    if (Ascii)
+      EXPECT_TRUE(test::forEachWordAscii(Input, Collect)) << Input;
+    else
+      test::forEachWordScalar(Input, Collect);
+    return Ret;
+  };
+
+  // Identifiers long enough to span several chunks, with boundaries at every
+  // position within a chunk and between chunks.
+  std::mt19937 Gen(20201);
+  const std::string Alphabet = "abcxyzABCXYZ_09$@`{[";
+  std::uniform_int_distribution<size_t> Char(0, Alphabet.size() - 1),
+      Length(0, 70);
+  for (int Iter = 0; Iter < 5000; ++Iter) {
+    std::string Input(Length(Gen), ' ');
+    for (char& C : Input)
+      C = Alphabet[Char(Gen)];
+    ASSERT_EQ(Words(true, Input), Words(false, Input)) << Input;
+  }
+  std::string Long = std::string(200, 'a') + "Bee_" + std::string(200, 'C');
+  EXPECT_EQ(Words(true, Long), Words(false, Long));
+
+  // Identifiers which are not ASCII are left to the scalar splitter.
+  EXPECT_FALSE(test::forEachWordAscii("caf\xc3\xa9" "Bar",
+                                      [](std::string_view) { FAIL(); }));
+  IdentifierSplitter Splitter;
+  EXPECT_THAT(Splitter.split("caf\xc3\xa9_bar"),
+              testing::UnorderedElementsAre("caf\xc3\xa9", "bar"));
+}
+
+TEST(IdentifierSplitting, splitInterned) {
+  IdentifierSplitter Splitter;
+  MorphemeInterner Interner;
+
+  MorphemeIdSet Morphemes = Splitter.split("foo_barBaz_bar", Interner);
+  EXPECT_EQ(Morphemes.size(), 3);
+  for (const char* Morph : {"foo", "bar", "baz"}) {
+    std::optional<MorphemeInterner::Id> Id = Interner.find(Morph);
+    ASSERT_TRUE(Id);
+    EXPECT_TRUE(Morphemes.contains(*Id));
+  }
+  EXPECT_EQ(Splitter.split("barFoo", Interner),
+            MorphemeIdSet({*Interner.find("foo"), *Interner.find("bar")}));
+}
+
+TEST(IdentifierSplitting, memo) {
+  IdentifierSplitter Splitter(2);
+  MorphemeInterner Interner;
+
+  MorphemeIdSet FooBar = Splitter.split("fooBar", Interner);
+  EXPECT_EQ(Splitter.split("fooBar", Interner), FooBar);
+  EXPECT_EQ(Splitter.memoHits(), 1);
+  EXPECT_EQ(Splitter.memoMisses(), 1);
+
+  // Filling the memo past its capacity starts it over.
+  Splitter.split("baz", Interner);
+  Splitter.split("quux", Interner);
+  EXPECT_EQ(Splitter.split("fooBar", Interner), FooBar);
+  EXPECT_EQ(Splitter.memoHits(), 1);
+  EXPECT_EQ(Splitter.memoMisses(), 4);
+
+  // Results are not shared with other interners.
+  MorphemeInterner Other;
+  MorphemeIdSet OtherFooBar = Splitter.split("fooBar", Other);
+  EXPECT_EQ(OtherFooBar.size(), 2);
+  EXPECT_TRUE(OtherFooBar.contains(*Other.find("foo")));
+  EXPECT_EQ(Splitter.memoHits(), 1);
+}
@@ -0,0 +1,76 @@
+//===- MorphemeInterner.test.cpp --------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+#include "MorphemeInterner.hpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace swapped_arg;
+
+TEST(MorphemeInterner, intern) {
+  MorphemeInterner Interner;
+
+  MorphemeInterner::Id Foo = Interner.intern("foo"),
+                       Bar = Interner.intern("bar");
+  EXPECT_NE(Foo, Bar);
+  EXPECT_EQ(Interner.intern("foo"), Foo);
+  EXPECT_EQ(Interner.find("bar"), Bar);
+  EXPECT_EQ(Interner.find("baz"), std::nullopt);
+  EXPECT_EQ(Interner.str(Foo), "foo");
+  EXPECT_EQ(Interner.str(Bar), "bar");
+  EXPECT_EQ(Interner.size(), 2);
+}
+
+TEST(MorphemeIdSet, operations) {
+  MorphemeIdSet Set{5, 1, 3, 1};
+  EXPECT_THAT(Set, testing::ElementsAre(1, 3, 5));
+  EXPECT_TRUE(Set.contains(3));
+  EXPECT_FALSE(Set.contains(2));
+
+  EXPECT_THAT(MorphemeIdSet::difference(Set, {3, 4}),
+              testing::ElementsAre(1, 5));
+  EXPECT_TRUE(MorphemeIdSet::difference(Set, Set).empty());
+  EXPECT_EQ(Set, MorphemeIdSet({1, 3, 5}));
+  EXPECT_NE(Set, MorphemeIdSet({1, 3}));
+
+  // Sets which outgrow their inline storage should behave the same.
+  MorphemeIdSet Large;
+  for (MorphemeInterner::Id Id = 20; Id > 0; --Id)
+    Large.insert(Id);
+  EXPECT_EQ(Large.size(), 20);
+  EXPECT_TRUE(std::is_sorted(Large.begin(), Large.end()));
+  EXPECT_THAT(MorphemeIdSet::difference(Large, Set), testing::SizeIs(17));
+  MorphemeIdSet Copy = Large;
+  EXPECT_EQ(Copy, Large);
+}
+
+TEST(MorphemeList, strings) {
+  MorphemeInterner Interner;
+  MorphemeInterner::Id Dogs = Interner.intern("dogs"),
+                       Cats = Interner.intern("cats");
+  Interner.intern("emus");
+
+  MorphemeList List(MorphemeIdSet{Cats, Dogs}, Interner);
+  EXPECT_THAT(List, testing::UnorderedElementsAre("cats", "dogs"));
+  EXPECT_EQ(List.size(), 2);
+  EXPECT_TRUE(List.contains("dogs"));
+  EXPECT_FALSE(List.contains("emus"));
+  EXPECT_FALSE(List.contains("horses"));
+
+  MorphemeList Copy = List;
+  EXPECT_EQ(Copy.ids(), List.ids());
+  EXPECT_TRUE(MorphemeList().empty());
+  EXPECT_FALSE(MorphemeList().contains("dogs"));
+}
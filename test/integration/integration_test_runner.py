@@ -30,6 +30,9 @@ with args.input as f:
     doc = json.loads(line)
 
     for fname, func in doc['functions'].items():
+      # Entries for overloaded functions are keyed by more than the name, and
+      # give the name separately.
+      fname = func.get("name", fname)
       decl_attrs = func.get("declAttrs", {})
       param_names = None
       call_decl_line = None
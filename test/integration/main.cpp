@@ -77,7 +77,7 @@ static bool runCheck(const std::string& functionName,
     std::cerr << "ERROR (" << callSiteFile << ":" << callSiteLineNum
               << "): " << site.callDecl.fullyQualifiedName
               << " has swapped arguments " << res.arg1 << " and " << res.arg2
-              << " with a score of " << res.score->score() << std::endl;
+              << " with a score of " << res.score.score() << std::endl;
     std::cerr << "NOTE (" << callDeclFile.value_or("<unknown>") << ":"
               << callDeclLineNum.value_or(std::numeric_limits<size_t>::max())
               << "): callee declared here" << std::endl;
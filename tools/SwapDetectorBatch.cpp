@@ -0,0 +1,533 @@
+//===- SwapDetectorBatch.cpp ------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+
+// Command line utility for checking every call site in a names database.
+//
+// Usage: SwapDetectorBatch [options] [<names.json>]
+//   Reads the newline-delimited JSON names database format consumed by
+//   test/integration/integration_test_runner.py from the given file, or from
+//   standard input, and checks every call site in it with a single Checker.
+//   Diagnostics are written to standard output as they are found, in the same
+//   format as IntegrationTestSwappedArgs.
+//
+// Options:
+//   --model <path>     The statistics model to check against.
+//   --in-memory        Load the whole statistics model into memory.
+//   --threads <count>  The number of threads to check with; zero, the default,
+//                      uses one thread for each hardware thread.
+//   --shard <i>/<n>    Checks only every n'th entry of the names database,
+//                      starting with entry i (counting from zero), so that a
+//                      large database can be split across n processes.
+
+#include "SwappedArgChecker.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace swapped_arg;
+
+namespace {
+// A pull parser over a single JSON document held in a mutable buffer. Strings
+// are returned as views into the buffer rather than copied out of it; escape
+// sequences are decoded in place, which is always possible because a decoded
+// escape is never longer than the escape itself.
+class JsonReader {
+public:
+  JsonReader(char* begin, char* end) : Cur(begin), End(end) {}
+
+  // Reads an object, calling fn(key) for each member. The callback must read
+  // or skip the member's value and return false if it could not.
+  template <typename Fn> bool object(Fn fn) {
+    if (!consume('{'))
+      return false;
+    if (consume('}'))
+      return true;
+    do {
+      std::string_view key;
+      if (!string(key) || !consume(':') || !fn(key))
+        return false;
+    } while (consume(','));
+    return consume('}');
+  }
+
+  // Reads an array, calling fn() for each element. The callback must read or
+  // skip the element and return false if it could not.
+  template <typename Fn> bool array(Fn fn) {
+    if (!consume('['))
+      return false;
+    if (consume(']'))
+      return true;
+    do {
+      if (!fn())
+        return false;
+    } while (consume(','));
+    return consume(']');
+  }
+
+  bool string(std::string_view& out);
+  // Reads a non-negative integer; any other kind of number is an error.
+  bool number(uint64_t& out);
+  // Skips over a value of any kind.
+  bool skip();
+
+  // Returns true if only whitespace remains in the document.
+  bool atEnd() {
+    skipSpace();
+    return Cur == End;
+  }
+
+private:
+  char* Cur;
+  char* End;
+
+  void skipSpace() {
+    while (Cur != End &&
+           (*Cur == ' ' || *Cur == '\t' || *Cur == '\n' || *Cur == '\r'))
+      ++Cur;
+  }
+
+  bool consume(char c) {
+    skipSpace();
+    if (Cur == End || *Cur != c)
+      return false;
+    ++Cur;
+    return true;
+  }
+
+  bool peek(char c) {
+    skipSpace();
+    return Cur != End && *Cur == c;
+  }
+
+  bool hex4(uint32_t& out);
+};
+
+bool JsonReader::string(std::string_view& out) {
+  if (!consume('"'))
+    return false;
+
+  // Most strings have no escapes and can be returned without touching them.
+  char* begin = Cur;
+  while (Cur != End && *Cur != '"' && *Cur != '\\')
+    ++Cur;
+  char* dest = Cur;
+  while (Cur != End && *Cur != '"') {
+    if (*Cur != '\\') {
+      *dest++ = *Cur++;
+      continue;
+    }
+    if (++Cur == End)
+      return false;
+    switch (*Cur++) {
+    case '"':
+      *dest++ = '"';
+      break;
+    case '\\':
+      *dest++ = '\\';
+      break;
+    case '/':
+      *dest++ = '/';
+      break;
+    case 'b':
+      *dest++ = '\b';
+      break;
+    case 'f':
+      *dest++ = '\f';
+      break;
+    case 'n':
+      *dest++ = '\n';
+      break;
+    case 'r':
+      *dest++ = '\r';
+      break;
+    case 't':
+      *dest++ = '\t';
+      break;
+    case 'u': {
+      uint32_t code;
+      if (!hex4(code))
+        return false;
+      // A high surrogate must be followed by an escaped low surrogate.
+      if (code >= 0xD800 && code < 0xDC00) {
+        uint32_t low;
+        if (End - Cur < 2 || Cur[0] != '\\' || Cur[1] != 'u')
+          return false;
+        Cur += 2;
+        if (!hex4(low) || low < 0xDC00 || low >= 0xE000)
+          return false;
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+      }
+      if (code < 0x80) {
+        *dest++ = static_cast<char>(code);
+      } else if (code < 0x800) {
+        *dest++ = static_cast<char>(0xC0 | (code >> 6));
+        *dest++ = static_cast<char>(0x80 | (code & 0x3F));
+      } else if (code < 0x10000) {
+        *dest++ = static_cast<char>(0xE0 | (code >> 12));
+        *dest++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *dest++ = static_cast<char>(0x80 | (code & 0x3F));
+      } else {
+        *dest++ = static_cast<char>(0xF0 | (code >> 18));
+        *dest++ = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        *dest++ = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        *dest++ = static_cast<char>(0x80 | (code & 0x3F));
+      }
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  if (Cur == End)
+    return false;
+  ++Cur;
+  out = std::string_view(begin, dest - begin);
+  return true;
+}
+
+bool JsonReader::hex4(uint32_t& out) {
+  if (End - Cur < 4)
+    return false;
+  out = 0;
+  for (int idx = 0; idx < 4; ++idx, ++Cur) {
+    char c = *Cur;
+    out <<= 4;
+    if (c >= '0' && c <= '9')
+      out |= c - '0';
+    else if (c >= 'a' && c <= 'f')
+      out |= c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      out |= c - 'A' + 10;
+    else
+      return false;
+  }
+  return true;
+}
+
+bool JsonReader::number(uint64_t& out) {
+  skipSpace();
+  if (Cur == End || *Cur < '0' || *Cur > '9')
+    return false;
+  out = 0;
+  while (Cur != End && *Cur >= '0' && *Cur <= '9') {
+    uint64_t digit = *Cur++ - '0';
+    if (out > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+      return false;
+    out = out * 10 + digit;
+  }
+  return Cur == End || (*Cur != '.' && *Cur != 'e' && *Cur != 'E');
+}
+
+bool JsonReader::skip() {
+  if (peek('{'))
+    return object([this](std::string_view) { return skip(); });
+  if (peek('['))
+    return array([this] { return skip(); });
+  if (peek('"')) {
+    std::string_view ignored;
+    return string(ignored);
+  }
+  // Everything else is a number or a literal, which ends at a delimiter.
+  char* begin = Cur;
+  while (Cur != End && *Cur != ',' && *Cur != '}' && *Cur != ']' &&
+         *Cur != ' ' && *Cur != '\t' && *Cur != '\n' && *Cur != '\r')
+    ++Cur;
+  return Cur != begin;
+}
+
+// A file and line in a names database, where the file is an index into the
+// fileNameMap of the database entry it came from.
+struct Location {
+  std::optional<uint64_t> File;
+  std::optional<uint64_t> Line;
+};
+
+bool readLocation(JsonReader& reader, Location& loc) {
+  return reader.object([&](std::string_view key) {
+    uint64_t value;
+    if (key == "file") {
+      if (!reader.number(value))
+        return false;
+      loc.File = value;
+      return true;
+    }
+    if (key == "lineNo") {
+      if (!reader.number(value))
+        return false;
+      loc.Line = value;
+      return true;
+    }
+    return reader.skip();
+  });
+}
+
+// Reads an array of objects with an optional "name" member, such as the
+// parameters of a declaration or the arguments at a call site. A missing name
+// is read as an empty one.
+template <typename Fn> bool readNames(JsonReader& reader, Fn fn) {
+  return reader.array([&] {
+    std::string_view name;
+    bool ok = reader.object([&](std::string_view key) {
+      return key == "name" ? reader.string(name) : reader.skip();
+    });
+    if (ok)
+      fn(name);
+    return ok;
+  });
+}
+
+// The call sites read from the names database which have not been checked
+// yet, along with where each one is for reporting diagnostics.
+struct Batch {
+  std::vector<CallSite> Sites;
+  // The site and callee declaration locations for each site. The files are
+  // indexes into FileNames.
+  std::vector<std::pair<Location, Location>> Locations;
+  std::vector<std::string> FileNames;
+
+  void clear() {
+    Sites.clear();
+    Locations.clear();
+    FileNames.clear();
+  }
+};
+
+// Reads every call site in one entry of a names database into the batch.
+// Returns false if the entry is malformed, leaving the batch unchanged.
+bool readEntry(char* begin, char* end, Batch& batch) {
+  JsonReader reader(begin, end);
+  size_t firstSite = batch.Sites.size(), firstFile = batch.FileNames.size();
+  std::vector<std::string_view> fileNames;
+
+  bool ok = reader.object([&](std::string_view key) {
+    if (key == "fileNameMap") {
+      return reader.array([&] {
+        std::string_view name;
+        if (!reader.string(name))
+          return false;
+        fileNames.push_back(name);
+        return true;
+      });
+    }
+    if (key != "functions")
+      return reader.skip();
+
+    return reader.object([&](std::string_view funcName) {
+      // The call sites may come before or after the declaration, so fill in
+      // the declaration for all of the function's sites once both are read.
+      size_t firstFuncSite = batch.Sites.size();
+      CallDeclDescriptor decl;
+      decl.fullyQualifiedName = funcName;
+      Location declLoc;
+
+      bool funcOk = reader.object([&](std::string_view funcKey) {
+        // Entries for overloaded functions are keyed by more than the name,
+        // and give the name separately.
+        if (funcKey == "name") {
+          std::string_view name;
+          if (!reader.string(name))
+            return false;
+          decl.fullyQualifiedName = name;
+          return true;
+        }
+        if (funcKey == "declAttrs") {
+          return reader.object([&](std::string_view declKey) {
+            if (declKey == "location")
+              return readLocation(reader, declLoc);
+            if (declKey != "params")
+              return reader.skip();
+            decl.paramNames.emplace();
+            return readNames(reader, [&](std::string_view name) {
+              decl.paramNames->emplace_back(name);
+            });
+          });
+        }
+        if (funcKey != "callSites")
+          return reader.skip();
+
+        return reader.array([&] {
+          CallSite site;
+          Location siteLoc;
+          bool siteOk = reader.object([&](std::string_view siteKey) {
+            if (siteKey == "site")
+              return readLocation(reader, siteLoc);
+            if (siteKey != "attrs")
+              return reader.skip();
+            return reader.object([&](std::string_view attrKey) {
+              if (attrKey != "args")
+                return reader.skip();
+              // Each argument is a single identifier.
+              return readNames(reader, [&](std::string_view name) {
+                site.positionalArgNames.push_back({std::string(name)});
+              });
+            });
+          });
+          if (siteOk) {
+            batch.Sites.push_back(std::move(site));
+            batch.Locations.emplace_back(siteLoc, Location());
+          }
+          return siteOk;
+        });
+      });
+
+      for (size_t idx = firstFuncSite; idx < batch.Sites.size(); ++idx) {
+        batch.Sites[idx].callDecl = decl;
+        batch.Locations[idx].second = declLoc;
+      }
+      return funcOk;
+    });
+  });
+
+  if (!ok || !reader.atEnd()) {
+    batch.Sites.resize(firstSite);
+    batch.Locations.resize(firstSite);
+    return false;
+  }
+
+  // Resolve the files now that the file name map has been read, dropping any
+  // which are not in it.
+  batch.FileNames.insert(batch.FileNames.end(), fileNames.begin(),
+                         fileNames.end());
+  auto resolve = [&](Location& loc) {
+    if (loc.File && *loc.File < fileNames.size())
+      *loc.File += firstFile;
+    else
+      loc.File.reset();
+  };
+  for (size_t idx = firstSite; idx < batch.Locations.size(); ++idx) {
+    resolve(batch.Locations[idx].first);
+    resolve(batch.Locations[idx].second);
+  }
+  return true;
+}
+
+// Checks every site in the batch, writes out the diagnostics, and empties the
+// batch.
+void checkBatch(Checker& checker, unsigned threads, Batch& batch,
+                std::ostream& out) {
+  std::vector<std::vector<Result>> results =
+      checker.CheckSites(batch.Sites, threads);
+  auto fileName = [&](const Location& loc) -> const std::string& {
+    static const std::string unknown = "<unknown>";
+    return loc.File ? batch.FileNames[*loc.File] : unknown;
+  };
+
+  for (size_t idx = 0; idx < results.size(); ++idx) {
+    const Location &siteLoc = batch.Locations[idx].first,
+                   &declLoc = batch.Locations[idx].second;
+    for (const Result& res : results[idx]) {
+      out << "ERROR (" << fileName(siteLoc) << ":" << siteLoc.Line.value_or(0)
+          << "): " << batch.Sites[idx].callDecl.fullyQualifiedName
+          << " has swapped arguments " << res.arg1 << " and " << res.arg2
+          << " with a score of " << res.score.score() << "\n";
+      out << "NOTE (" << fileName(declLoc) << ":"
+          << declLoc.Line.value_or(std::numeric_limits<size_t>::max())
+          << "): callee declared here\n";
+    }
+  }
+  out.flush();
+  batch.clear();
+}
+} // namespace
+
+static void printUsage() {
+  std::cout << "[--model <path>] [--in-memory] [--threads <count>] "
+               "[--shard <i>/<n>] [<names.json>]\n"
+            << "  Checks every call site in a names database, read from the "
+               "given file\n"
+            << "  or from standard input.\n";
+}
+
+int main(int argc, char* argv[]) {
+  // Sites are checked in batches so that diagnostics stream out while the
+  // rest of the input is still being read.
+  constexpr size_t BatchSize = 16384;
+
+  CheckerConfiguration config;
+  unsigned threads = 0;
+  unsigned long shardIndex = 0, shardCount = 1;
+  std::optional<std::string> inputPath;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--model" && i + 1 < argc) {
+      config.ModelPath = argv[++i];
+    } else if (arg == "--in-memory") {
+      config.LoadModelInMemory = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      char* end;
+      unsigned long count = std::strtoul(argv[++i], &end, 10);
+      if (*end || count > std::numeric_limits<unsigned>::max()) {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+      threads = static_cast<unsigned>(count);
+    } else if (arg == "--shard" && i + 1 < argc) {
+      char* end;
+      shardIndex = std::strtoul(argv[++i], &end, 10);
+      bool valid = *end == '/';
+      if (valid) {
+        shardCount = std::strtoul(end + 1, &end, 10);
+        valid = !*end && shardIndex < shardCount;
+      }
+      if (!valid) {
+        printUsage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg.substr(0, 2) != "--" && !inputPath) {
+      inputPath = arg;
+    } else {
+      printUsage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::ifstream file;
+  if (inputPath) {
+    file.open(*inputPath, std::ios::binary);
+    if (!file) {
+      std::cerr << "error: unable to open " << *inputPath << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  std::istream& in = inputPath ? file : std::cin;
+
+  Checker checker(config);
+  Batch batch;
+  std::string line;
+  size_t entryNo = 0;
+  for (size_t lineNo = 1; std::getline(in, line); ++lineNo) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+    // Entries in other shards are skipped without being parsed.
+    if (entryNo++ % shardCount != shardIndex)
+      continue;
+    if (!readEntry(line.data(), line.data() + line.size(), batch)) {
+      std::cerr << "error: malformed names database entry on line " << lineNo
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (batch.Sites.size() >= BatchSize)
+      checkBatch(checker, threads, batch, std::cout);
+  }
+  checkBatch(checker, threads, batch, std::cout);
+  return EXIT_SUCCESS;
+}
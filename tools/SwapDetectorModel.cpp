@@ -0,0 +1,65 @@
+//===- SwapDetectorModel.cpp ------------------------------------*- C++ -*-===//
+//
+//  Copyright (C) 2020 GrammaTech, Inc.
+//
+//  This code is licensed under the MIT license. See the LICENSE file in the
+//  project root for license terms.
+//
+// This material is based on research sponsored by the Department of Homeland
+// Security (DHS) Office of Procurement Operations, S&T acquisition Division via
+// contract number 70RSAT19C00000056. The views and conclusions contained herein
+// are those of the authors and should not be interpreted as necessarily
+// representing the official policies or endorsements, either expressed or
+// implied, of the Department of Homeland Security.
+//
+//===----------------------------------------------------------------------===//
+
+// Command line utility for maintaining statistics models.
+//
+// Usage: SwapDetectorModel convert <input.db> <output.model>
+//   Converts a SQLite statistics model into the binary model format, which
+//   can be used anywhere a model path is accepted.
+//
+// Usage: SwapDetectorModel optimize <model.db>
+//   Adds the indexes the checker relies on for fast lookups to a SQLite
+//   statistics model, if they are missing.
+
+#include "StatisticsModel.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace swapped_arg;
+
+static void printUsage() {
+  std::cout << "convert <input.db> <output.model>\n"
+            << "  Converts a SQLite model into the binary model format.\n"
+            << "optimize <model.db>\n"
+            << "  Indexes a SQLite model for faster lookups.\n";
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  std::string command(argv[1]), error;
+  if (command == "convert" && argc == 4) {
+    if (!model::convertToBinary(argv[2], argv[3], error)) {
+      std::cerr << "error: " << error << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+  if (command == "optimize" && argc == 3) {
+    if (!model::optimize(argv[2], error)) {
+      std::cerr << "error: " << error << std::endl;
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  printUsage();
+  return EXIT_FAILURE;
+}